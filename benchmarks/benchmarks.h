@@ -0,0 +1,99 @@
+#ifndef BENCHMARKS_H
+#define BENCHMARKS_H
+
+#include <QObject>
+#include "mockcompletionserver.h"
+
+class HighlighterBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void highlightDocument_data();
+    void highlightDocument();
+    void editLargeDocument_data();
+    void editLargeDocument();
+};
+
+class ContextBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void countTokens_data();
+    void countTokens();
+    void buildPrompt_data();
+    void buildPrompt();
+    void buildPromptAfterEdit_data();
+    void buildPromptAfterEdit();
+    void editScopeIndex_data();
+    void editScopeIndex();
+};
+
+class FileBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void readFile_data();
+    void readFile();
+    void writeFile_data();
+    void writeFile();
+    void searchProject_data();
+    void searchProject();
+    void replaceProject_data();
+    void replaceProject();
+};
+
+class OutputBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void ingestLines_data();
+    void ingestLines();
+};
+
+class UndoBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void undoRedo_data();
+    void undoRedo();
+    void typeKeystrokes_data();
+    void typeKeystrokes();
+    void roundTrip();
+};
+
+class JudgeBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void compareOutput_data();
+    void compareOutput();
+    void compareLargeOutput();
+    void wallTimeout();
+};
+
+class CompletionBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void roundTrip_data();
+    void roundTrip();
+    void roundTripTls_data();
+    void roundTripTls();
+    void pipeline();
+    void cycleCandidates();
+
+private:
+    MockCompletionServer server;
+    MockCompletionServer tlsServer;
+    QSslCertificate certificate;
+};
+
+#endif // BENCHMARKS_H
@@ -0,0 +1,36 @@
+TARGET = ide-benchmarks
+TEMPLATE = app
+
+include(../ide.pri)
+
+QT += testlib
+CONFIG += console testcase
+CONFIG -= app_bundle
+
+SOURCES += \
+    main.cpp \
+    mockcompletionserver.cpp \
+    highlighterbenchmark.cpp \
+    contextbenchmark.cpp \
+    filebenchmark.cpp \
+    outputbenchmark.cpp \
+    undobenchmark.cpp \
+    judgebenchmark.cpp \
+    completionbenchmark.cpp \
+    synthetic.cpp
+
+HEADERS += \
+    mockcompletionserver.h \
+    benchmarks.h \
+    synthetic.h
+
+# Self-signed certificate for 127.0.0.1, served by the TLS mock endpoint
+RESOURCES += \
+    benchmarks.qrc
+
+# Output directories
+DESTDIR = $$OUT_PWD/../build/
+OBJECTS_DIR = $$OUT_PWD/../build/obj/benchmarks/
+MOC_DIR = $$OUT_PWD/../build/moc/benchmarks/
+RCC_DIR = $$OUT_PWD/../build/rcc/benchmarks/
+UI_DIR = $$OUT_PWD/../build/ui/benchmarks/
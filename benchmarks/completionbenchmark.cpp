@@ -0,0 +1,179 @@
+#include "benchmarks.h"
+#include "completionclient.h"
+#include "contextbuilder.h"
+#include "completionwidget.h"
+#include "synthetic.h"
+#include <QTest>
+#include <QSignalSpy>
+#include <QTextEdit>
+#include <QTextBlock>
+#include <QJsonArray>
+#include <QFile>
+
+static QJsonObject requestBody(const QString &prompt)
+{
+    QJsonObject message;
+    message["role"] = "user";
+    message["content"] = prompt;
+
+    QJsonObject json;
+    json["model"] = "mock";
+    json["messages"] = QJsonArray{message};
+    json["max_tokens"] = 50;
+    json["n"] = 3;
+    return json;
+}
+
+void CompletionBenchmark::initTestCase()
+{
+    server.setCompletions({"int result = 0;", "return total;", "int result = 0;"});
+    QVERIFY(server.start());
+
+    QFile certificateFile(":/tls/localhost.crt");
+    QFile keyFile(":/tls/localhost.key");
+    QVERIFY(certificateFile.open(QIODevice::ReadOnly));
+    QVERIFY(keyFile.open(QIODevice::ReadOnly));
+    certificate = QSslCertificate(certificateFile.readAll(), QSsl::Pem);
+    QSslKey key(keyFile.readAll(), QSsl::Rsa, QSsl::Pem);
+    QVERIFY(!certificate.isNull());
+    QVERIFY(!key.isNull());
+    tlsServer.setTlsCertificate(certificate, key);
+    tlsServer.setCompletions({"int result = 0;", "return total;", "int result = 0;"});
+    QVERIFY(tlsServer.start());
+}
+
+void CompletionBenchmark::roundTrip_data()
+{
+    QTest::addColumn<bool>("warm");
+    QTest::newRow("new connection") << false;
+    QTest::newRow("kept-alive connection") << true;
+}
+
+void CompletionBenchmark::roundTrip()
+{
+    QFETCH(bool, warm);
+    const QJsonObject body = requestBody("int main() {\n    <CURSOR>\n}");
+
+    if (warm) {
+        CompletionClient client;
+        client.setKeepWarmPolicy(CompletionClient::WarmOnStartup);
+        client.setEndpoint(server.url());
+        QSignalSpy spy(&client, &CompletionClient::replyReceived);
+        QBENCHMARK {
+            client.send(body);
+            QVERIFY(spy.wait(5000));
+        }
+    } else {
+        QBENCHMARK {
+            // A fresh client has no pooled connection and pays the TCP setup
+            CompletionClient client;
+            client.setKeepWarmPolicy(CompletionClient::NoKeepWarm);
+            client.setEndpoint(server.url());
+            QSignalSpy spy(&client, &CompletionClient::replyReceived);
+            client.send(body);
+            QVERIFY(spy.wait(5000));
+            QVERIFY(spy.first().at(2).value<RequestTiming>().connectMs >= 0);
+        }
+    }
+}
+
+void CompletionBenchmark::roundTripTls_data()
+{
+    roundTrip_data();
+}
+
+void CompletionBenchmark::roundTripTls()
+{
+    QFETCH(bool, warm);
+    const QJsonObject body = requestBody("int main() {\n    <CURSOR>\n}");
+
+    // Trust the mock's self-signed certificate while still offering HTTP/2 through ALPN
+    QSslConfiguration config = QSslConfiguration::defaultConfiguration();
+    config.setCaCertificates(config.caCertificates() << certificate);
+    config.setAllowedNextProtocols({QSslConfiguration::ALPNProtocolHTTP2,
+                                    QSslConfiguration::NextProtocolHttp1_1});
+
+    if (warm) {
+        CompletionClient client;
+        client.setSslConfiguration(config);
+        client.setKeepWarmPolicy(CompletionClient::WarmOnStartup);
+        client.setEndpoint(tlsServer.url());
+        QSignalSpy spy(&client, &CompletionClient::replyReceived);
+        QSignalSpy failures(&client, &CompletionClient::requestFailed);
+
+        // The first request completes the handshake if the pre-connect has not yet
+        client.send(body);
+        QVERIFY(spy.wait(5000));
+        QCOMPARE(failures.count(), 0);
+        spy.clear();
+        QBENCHMARK {
+            client.send(body);
+            QVERIFY(spy.wait(5000));
+            // The mock only speaks HTTP/1.1, so ALPN must fall back to it
+            RequestTiming timing = spy.takeFirst().at(2).value<RequestTiming>();
+            QCOMPARE(timing.connectMs, qint64(-1));
+            QVERIFY(!timing.http2);
+        }
+    } else {
+        QBENCHMARK {
+            // A fresh client pays the TCP and TLS handshakes
+            CompletionClient client;
+            client.setSslConfiguration(config);
+            client.setKeepWarmPolicy(CompletionClient::NoKeepWarm);
+            client.setEndpoint(tlsServer.url());
+            QSignalSpy spy(&client, &CompletionClient::replyReceived);
+            QSignalSpy failures(&client, &CompletionClient::requestFailed);
+            client.send(body);
+            QVERIFY2(spy.wait(5000), failures.isEmpty() ? "no reply"
+                                     : qPrintable(failures.first().at(2).toString()));
+            RequestTiming timing = spy.first().at(2).value<RequestTiming>();
+            QVERIFY(timing.connectMs >= 0);
+            QVERIFY(!timing.http2);
+        }
+    }
+}
+
+void CompletionBenchmark::pipeline()
+{
+    const int lines = 10000;
+    QTextEdit editor;
+    editor.setPlainText(syntheticSource(lines));
+    QTextCursor cursor(editor.document()->findBlockByNumber(lines / 2));
+    editor.setTextCursor(cursor);
+    ContextBuilder builder(&editor);
+
+    CompletionClient client;
+    client.setEndpoint(server.url());
+    QSignalSpy spy(&client, &CompletionClient::replyReceived);
+
+    // Prompt packing, request, and parsing of the returned choices
+    QBENCHMARK {
+        client.send(requestBody(builder.buildPrompt()));
+        QVERIFY(spy.wait(5000));
+        QJsonObject response = spy.takeFirst().at(1).toJsonObject();
+        QCOMPARE(response["choices"].toArray().size(), 3);
+    }
+}
+
+void CompletionBenchmark::cycleCandidates()
+{
+    QTextEdit editor;
+    editor.resize(800, 600);
+    editor.show();
+    QVERIFY(QTest::qWaitForWindowExposed(&editor));
+    CompletionWidget widget(&editor);
+
+    // QTest presses Alt on its own before the bracket, as a keyboard does
+    widget.showCandidates({"int first;", "int second;", "int third;"});
+    QVERIFY(widget.isVisible());
+    QTest::keyClick(&editor, Qt::Key_BracketRight, Qt::AltModifier);
+    QVERIFY(widget.isVisible());
+    QCOMPARE(widget.currentCompletion(), QString("int second;"));
+    QTest::keyClick(&editor, Qt::Key_BracketLeft, Qt::AltModifier);
+    QTest::keyClick(&editor, Qt::Key_BracketLeft, Qt::AltModifier);
+    QCOMPARE(widget.currentCompletion(), QString("int third;"));
+
+    // Ctrl+Alt+] is left to the fold shortcut
+    QTest::keyClick(&editor, Qt::Key_BracketRight, Qt::ControlModifier | Qt::AltModifier);
+    QVERIFY(!widget.isVisible());
+}
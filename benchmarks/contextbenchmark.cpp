@@ -0,0 +1,115 @@
+#include "benchmarks.h"
+#include "contextbuilder.h"
+#include "scopeindex.h"
+#include "synthetic.h"
+#include <QTest>
+#include <QTextEdit>
+#include <QTextBlock>
+
+static void placeCursorMidway(QTextEdit *editor, int lines)
+{
+    QTextCursor cursor(editor->document()->findBlockByNumber(lines / 2));
+    cursor.movePosition(QTextCursor::EndOfBlock);
+    editor->setTextCursor(cursor);
+}
+
+void ContextBenchmark::countTokens_data()
+{
+    QTest::addColumn<int>("lines");
+    QTest::newRow("1k lines") << 1000;
+    QTest::newRow("10k lines") << 10000;
+}
+
+void ContextBenchmark::countTokens()
+{
+    QFETCH(int, lines);
+    const QString source = syntheticSource(lines);
+    int tokens = 0;
+    QBENCHMARK {
+        tokens = TokenCounter::count(source);
+    }
+    QVERIFY(tokens > 0);
+}
+
+void ContextBenchmark::buildPrompt_data()
+{
+    QTest::addColumn<int>("lines");
+    QTest::addColumn<int>("budget");
+    QTest::newRow("1k lines, 1k tokens") << 1000 << 1024;
+    QTest::newRow("10k lines, 1k tokens") << 10000 << 1024;
+    QTest::newRow("10k lines, 4k tokens") << 10000 << 4096;
+    QTest::newRow("50k lines, 4k tokens") << 50000 << 4096;
+}
+
+void ContextBenchmark::buildPrompt()
+{
+    QFETCH(int, lines);
+    QFETCH(int, budget);
+
+    QTextEdit editor;
+    editor.setPlainText(syntheticSource(lines));
+    placeCursorMidway(&editor, lines);
+    ContextBuilder builder(&editor);
+    builder.setTokenBudget(budget);
+
+    QString prompt;
+    QBENCHMARK {
+        prompt = builder.buildPrompt();
+    }
+    QVERIFY(builder.lastPromptTokens() <= budget + 64);
+}
+
+void ContextBenchmark::buildPromptAfterEdit_data()
+{
+    buildPrompt_data();
+}
+
+void ContextBenchmark::buildPromptAfterEdit()
+{
+    QFETCH(int, lines);
+    QFETCH(int, budget);
+
+    QTextEdit editor;
+    editor.setPlainText(syntheticSource(lines));
+    placeCursorMidway(&editor, lines);
+    ContextBuilder builder(&editor);
+    builder.setTokenBudget(budget);
+
+    // Typing between requests invalidates anything cached per document revision
+    QBENCHMARK {
+        editor.textCursor().insertText(" ");
+        builder.buildPrompt();
+    }
+}
+
+void ContextBenchmark::editScopeIndex_data()
+{
+    QTest::addColumn<int>("lines");
+    QTest::addColumn<QString>("text");
+    QTest::newRow("10k lines, keystroke") << 10000 << "x";
+    QTest::newRow("10k lines, brace") << 10000 << "{";
+    QTest::newRow("50k lines, keystroke") << 50000 << "x";
+    QTest::newRow("50k lines, brace") << 50000 << "{";
+}
+
+void ContextBenchmark::editScopeIndex()
+{
+    QFETCH(int, lines);
+    QFETCH(QString, text);
+
+    QTextDocument document;
+    document.setPlainText(syntheticSource(lines));
+    ScopeIndex *index = ScopeIndex::of(&document);
+
+    // A keystroke rescans one block; a brace shifts the depth of everything after it
+    QTextCursor cursor(document.findBlockByNumber(lines / 2));
+    cursor.movePosition(QTextCursor::EndOfBlock);
+    int start = -1;
+    QBENCHMARK {
+        cursor.insertText(text);
+        start = index->scopeStart(cursor.position());
+        cursor.deletePreviousChar();
+    }
+    Q_UNUSED(start);
+    QVERIFY(ScopeIndex::data(cursor.block()));
+}
@@ -0,0 +1,120 @@
+#include "benchmarks.h"
+#include "sourcefile.h"
+#include "projectreplace.h"
+#include "synthetic.h"
+#include <QTest>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QDirIterator>
+#include <utility>
+
+void FileBenchmark::readFile_data()
+{
+    QTest::addColumn<int>("lines");
+    QTest::newRow("1k lines") << 1000;
+    QTest::newRow("100k lines") << 100000;
+}
+
+void FileBenchmark::readFile()
+{
+    QFETCH(int, lines);
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString fileName = dir.filePath("source.cpp");
+    QVERIFY(SourceFile::write(fileName, syntheticSource(lines)));
+
+    QString text;
+    QBENCHMARK {
+        QVERIFY(SourceFile::read(fileName, &text));
+    }
+}
+
+void FileBenchmark::writeFile_data()
+{
+    readFile_data();
+}
+
+void FileBenchmark::writeFile()
+{
+    QFETCH(int, lines);
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString fileName = dir.filePath("source.cpp");
+    const QString text = syntheticSource(lines);
+
+    QBENCHMARK {
+        QVERIFY(SourceFile::write(fileName, text));
+    }
+}
+
+// A project of small source files, as a large refactor would touch
+static void writeProject(const QTemporaryDir &dir, int files)
+{
+    const QString text = syntheticSource(200);
+    for (int i = 0; i < files; ++i) {
+        const QString subdirectory = QString("module%1").arg(i % 16);
+        QDir(dir.path()).mkpath(subdirectory);
+        SourceFile::write(dir.filePath(QString("%1/unit%2.cpp").arg(subdirectory).arg(i)), text);
+    }
+}
+
+void FileBenchmark::searchProject_data()
+{
+    QTest::addColumn<int>("files");
+    QTest::addColumn<bool>("regex");
+    QTest::newRow("1k files, literal") << 1000 << false;
+    QTest::newRow("1k files, regex") << 1000 << true;
+}
+
+void FileBenchmark::searchProject()
+{
+    QFETCH(int, files);
+    QFETCH(bool, regex);
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    writeProject(dir, files);
+
+    ReplaceOptions options;
+    options.pattern = regex ? "Record(\\d+)" : "accumulate";
+    options.regex = regex;
+    ProjectReplace engine;
+    QSignalSpy finished(&engine, &ProjectReplace::searchFinished);
+    QBENCHMARK {
+        engine.search(dir.path(), options);
+        QVERIFY(finished.wait(60000));
+    }
+    QCOMPARE(finished.last().at(0).toInt(), files);
+}
+
+void FileBenchmark::replaceProject_data()
+{
+    QTest::addColumn<int>("files");
+    QTest::newRow("1k files") << 1000;
+}
+
+void FileBenchmark::replaceProject()
+{
+    QFETCH(int, files);
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    writeProject(dir, files);
+
+    QStringList paths;
+    QDirIterator it(dir.path(), QStringList{"*.cpp"}, QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        paths.append(it.next());
+    }
+
+    // Renames back and forth, so every iteration rewrites every file
+    ReplaceOptions options;
+    options.pattern = "accumulate";
+    options.replacement = "accumulateAll";
+    ProjectReplace engine;
+    QSignalSpy finished(&engine, &ProjectReplace::applyFinished);
+    QBENCHMARK {
+        engine.apply(paths, options);
+        QVERIFY(finished.wait(60000));
+        QCOMPARE(finished.last().at(2).toInt(), 0);
+        std::swap(options.pattern, options.replacement);
+    }
+}
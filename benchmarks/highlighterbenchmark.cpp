@@ -0,0 +1,48 @@
+#include "benchmarks.h"
+#include "highlighter.h"
+#include "synthetic.h"
+#include <QTest>
+#include <QTextDocument>
+#include <QTextCursor>
+#include <QTextBlock>
+
+void HighlighterBenchmark::highlightDocument_data()
+{
+    QTest::addColumn<int>("lines");
+    QTest::newRow("1k lines") << 1000;
+    QTest::newRow("10k lines") << 10000;
+    QTest::newRow("50k lines") << 50000;
+}
+
+void HighlighterBenchmark::highlightDocument()
+{
+    QFETCH(int, lines);
+    const QString source = syntheticSource(lines);
+
+    // Loading a document highlights every block once
+    QTextDocument document;
+    Highlighter highlighter(&document);
+    QBENCHMARK {
+        document.setPlainText(source);
+    }
+}
+
+void HighlighterBenchmark::editLargeDocument_data()
+{
+    highlightDocument_data();
+}
+
+void HighlighterBenchmark::editLargeDocument()
+{
+    QFETCH(int, lines);
+    QTextDocument document;
+    Highlighter highlighter(&document);
+    document.setPlainText(syntheticSource(lines));
+
+    // A keystroke in the middle of the file should only rehighlight nearby blocks
+    QTextCursor cursor(document.findBlockByNumber(lines / 2));
+    QBENCHMARK {
+        cursor.insertText("x");
+        cursor.deletePreviousChar();
+    }
+}
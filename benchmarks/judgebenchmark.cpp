@@ -0,0 +1,108 @@
+#include "benchmarks.h"
+#include "judgerunner.h"
+#include "outputcomparator.h"
+#include <QTest>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+#include <QElapsedTimer>
+#include <QFile>
+
+static QString writeFile(const QTemporaryDir &dir, const QString &name, const QByteArray &contents)
+{
+    const QString path = dir.filePath(name);
+    QFile file(path);
+    if (file.open(QIODevice::WriteOnly)) {
+        file.write(contents);
+    }
+    return path;
+}
+
+void JudgeBenchmark::compareOutput_data()
+{
+    QTest::addColumn<QByteArray>("expected");
+    QTest::addColumn<QByteArray>("actual");
+    QTest::addColumn<bool>("matches");
+    QTest::addColumn<int>("mismatchToken");
+    QTest::newRow("identical") << QByteArray("1 2 3\n") << QByteArray("1 2 3\n") << true << 0;
+    QTest::newRow("missing trailing newline") << QByteArray("1 2 3\n") << QByteArray("1 2 3") << true << 0;
+    QTest::newRow("extra trailing newlines") << QByteArray("1 2 3") << QByteArray("1 2 3\n\n\n") << true << 0;
+    QTest::newRow("whitespace runs") << QByteArray("1  2\t3\n") << QByteArray("1 2\n3") << true << 0;
+    QTest::newRow("CRLF line ends") << QByteArray("1\r\n2\r\n") << QByteArray("1\n2\n") << true << 0;
+    QTest::newRow("leading whitespace") << QByteArray("\n 42") << QByteArray("42\n") << true << 0;
+    QTest::newRow("both empty") << QByteArray() << QByteArray("\n") << true << 0;
+    QTest::newRow("wrong token") << QByteArray("1 2 3\n") << QByteArray("1 2 4\n") << false << 3;
+    QTest::newRow("extra token") << QByteArray("1 2\n") << QByteArray("1 2 3\n") << false << 3;
+    QTest::newRow("missing token") << QByteArray("1 2 3\n") << QByteArray("1 2\n") << false << 3;
+    QTest::newRow("token cut short") << QByteArray("123\n") << QByteArray("12") << false << 1;
+    QTest::newRow("tokens joined") << QByteArray("1 2\n") << QByteArray("12\n") << false << 1;
+    QTest::newRow("no output") << QByteArray("5\n") << QByteArray() << false << 1;
+}
+
+void JudgeBenchmark::compareOutput()
+{
+    QFETCH(QByteArray, expected);
+    QFETCH(QByteArray, actual);
+    QFETCH(bool, matches);
+    QFETCH(int, mismatchToken);
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+
+    // Fed a byte at a time as well, since the pipe may split the output anywhere
+    for (int chunk : {qMax(1, actual.size()), 1}) {
+        OutputComparator comparator(writeFile(dir, "case.out", expected));
+        QVERIFY(comparator.isOpen());
+        for (int i = 0; i < actual.size(); i += chunk) {
+            comparator.feed(actual.constData() + i, qMin(chunk, actual.size() - i));
+        }
+        comparator.finish();
+        QCOMPARE(!comparator.hasMismatch(), matches);
+        if (!matches) {
+            QCOMPARE(comparator.mismatchToken(), qint64(mismatchToken));
+        }
+    }
+}
+
+void JudgeBenchmark::compareLargeOutput()
+{
+    QByteArray output;
+    for (int i = 0; i < 1000000; ++i) {
+        output += QByteArray::number(i) + (i % 10 == 9 ? '\n' : ' ');
+    }
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString expectedPath = writeFile(dir, "case.out", output);
+
+    QBENCHMARK {
+        OutputComparator comparator(expectedPath);
+        for (int i = 0; i < output.size(); i += 64 * 1024) {
+            comparator.feed(output.constData() + i, qMin(64 * 1024, output.size() - i));
+        }
+        comparator.finish();
+        QVERIFY(!comparator.hasMismatch());
+    }
+}
+
+void JudgeBenchmark::wallTimeout()
+{
+#ifdef Q_OS_UNIX
+    // Closes stdout and then blocks without using CPU, so only the wall clock can stop it
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString program = writeFile(dir, "blocks.sh", "#!/bin/sh\nexec >&-\nsleep 30\n");
+    QVERIFY(QFile::setPermissions(program, QFile::ReadOwner | QFile::WriteOwner | QFile::ExeOwner));
+    writeFile(dir, "case.in", "");
+    writeFile(dir, "case.out", "1\n");
+
+    JudgeRunner runner;
+    runner.setTimeLimit(100);
+    QSignalSpy spy(&runner, &JudgeRunner::caseFinished);
+    QElapsedTimer timer;
+    timer.start();
+    runner.start(program, JudgeRunner::discoverCases(dir.path()));
+    QVERIFY(spy.wait(10000));
+    QVERIFY(timer.elapsed() < 10000);
+    QCOMPARE(spy.first().at(0).value<JudgeResult>().verdict, JudgeResult::TimeLimitExceeded);
+#else
+    QSKIP("Judge mode requires a POSIX system");
+#endif
+}
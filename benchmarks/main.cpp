@@ -0,0 +1,106 @@
+#include "benchmarks.h"
+#include <QApplication>
+#include <QTest>
+#include <QTemporaryDir>
+#include <QXmlStreamReader>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QDateTime>
+#include <QSysInfo>
+#include <QFile>
+#include <QTextStream>
+#include <memory>
+
+// Collects the <BenchmarkResult> entries of a QTest XML log
+static void collectResults(const QString &suite, const QString &xmlPath, QJsonArray *results)
+{
+    QFile file(xmlPath);
+    if (!file.open(QIODevice::ReadOnly)) return;
+
+    QXmlStreamReader xml(&file);
+    QString function;
+    while (!xml.atEnd()) {
+        xml.readNext();
+        if (!xml.isStartElement()) continue;
+
+        QXmlStreamAttributes attributes = xml.attributes();
+        if (xml.name() == QLatin1String("TestFunction")) {
+            function = attributes.value("name").toString();
+        } else if (xml.name() == QLatin1String("BenchmarkResult")) {
+            QJsonObject result;
+            result["suite"] = suite;
+            result["benchmark"] = function;
+            result["tag"] = attributes.value("tag").toString();
+            result["metric"] = attributes.value("metric").toString();
+            result["value"] = attributes.value("value").toDouble();
+            result["iterations"] = attributes.value("iterations").toInt();
+            results->append(result);
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    // Benchmarks create widgets but never need a display
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QApplication app(argc, argv);
+
+    // "-json <file>" selects where results go (stdout by default); other arguments go to QTest
+    QStringList passThrough = app.arguments();
+    QString jsonPath;
+    int jsonIndex = passThrough.indexOf("-json");
+    if (jsonIndex > 0 && jsonIndex + 1 < passThrough.size()) {
+        jsonPath = passThrough.at(jsonIndex + 1);
+        passThrough.erase(passThrough.begin() + jsonIndex, passThrough.begin() + jsonIndex + 2);
+    }
+
+    QTemporaryDir logDir;
+    if (!logDir.isValid()) return 1;
+
+    std::unique_ptr<QObject> suites[] = {
+        std::unique_ptr<QObject>(new HighlighterBenchmark),
+        std::unique_ptr<QObject>(new ContextBenchmark),
+        std::unique_ptr<QObject>(new FileBenchmark),
+        std::unique_ptr<QObject>(new OutputBenchmark),
+        std::unique_ptr<QObject>(new UndoBenchmark),
+        std::unique_ptr<QObject>(new JudgeBenchmark),
+        std::unique_ptr<QObject>(new CompletionBenchmark)
+    };
+
+    int failures = 0;
+    QJsonArray results;
+    for (const std::unique_ptr<QObject> &suite : suites) {
+        const QString name = suite->metaObject()->className();
+        const QString xmlPath = logDir.filePath(name + ".xml");
+
+        // Structured results go to the XML log; plain progress only when stdout is free
+        QStringList arguments = passThrough;
+        arguments << "-o" << xmlPath + ",xml";
+        if (!jsonPath.isEmpty()) {
+            arguments << "-o" << "-,txt";
+        }
+        failures += QTest::qExec(suite.get(), arguments);
+        collectResults(name, xmlPath, &results);
+    }
+
+    QJsonObject report;
+    report["timestamp"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    report["qtVersion"] = QString(qVersion());
+    report["host"] = QSysInfo::machineHostName();
+    report["cpu"] = QSysInfo::currentCpuArchitecture();
+    report["failures"] = failures;
+    report["results"] = results;
+    QByteArray json = QJsonDocument(report).toJson();
+
+    if (jsonPath.isEmpty()) {
+        QTextStream(stdout) << json;
+    } else {
+        QFile out(jsonPath);
+        if (!out.open(QIODevice::WriteOnly | QIODevice::Truncate)) return 1;
+        out.write(json);
+    }
+    return failures == 0 ? 0 : 1;
+}
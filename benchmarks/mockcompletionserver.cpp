@@ -0,0 +1,137 @@
+#include "mockcompletionserver.h"
+#include <QSslSocket>
+#include <QHostAddress>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QTimer>
+
+MockCompletionServer::MockCompletionServer(QObject *parent)
+    : QTcpServer(parent), completions{"int result = 0;"}, responseDelay(0), requests(0)
+{
+}
+
+bool MockCompletionServer::start(quint16 port)
+{
+    return listen(QHostAddress::LocalHost, port);
+}
+
+QUrl MockCompletionServer::url() const
+{
+    return QUrl(QString("%1://127.0.0.1:%2/v1/chat/completions")
+                .arg(certificate.isNull() ? "http" : "https")
+                .arg(serverPort()));
+}
+
+void MockCompletionServer::setCompletions(const QStringList &newCompletions)
+{
+    completions = newCompletions;
+}
+
+void MockCompletionServer::setResponseDelay(int ms)
+{
+    responseDelay = ms;
+}
+
+void MockCompletionServer::setTlsCertificate(const QSslCertificate &newCertificate, const QSslKey &key)
+{
+    certificate = newCertificate;
+    privateKey = key;
+}
+
+int MockCompletionServer::requestCount() const
+{
+    return requests;
+}
+
+void MockCompletionServer::incomingConnection(qintptr socketDescriptor)
+{
+    QTcpSocket *socket;
+    if (!certificate.isNull()) {
+        QSslSocket *sslSocket = new QSslSocket(this);
+        sslSocket->setSocketDescriptor(socketDescriptor);
+        sslSocket->setLocalCertificate(certificate);
+        sslSocket->setPrivateKey(privateKey);
+        sslSocket->startServerEncryption();
+        socket = sslSocket;
+    } else {
+        socket = new QTcpSocket(this);
+        socket->setSocketDescriptor(socketDescriptor);
+    }
+
+    connect(socket, &QTcpSocket::readyRead, this, &MockCompletionServer::readRequest);
+    connect(socket, &QTcpSocket::disconnected, this, [this, socket]() {
+        buffers.remove(socket);
+        socket->deleteLater();
+    });
+}
+
+void MockCompletionServer::readRequest()
+{
+    QTcpSocket *socket = qobject_cast<QTcpSocket *>(sender());
+    if (!socket) return;
+
+    QByteArray &buffer = buffers[socket];
+    buffer.append(socket->readAll());
+
+    // Several pipelined requests may arrive on one keep-alive connection
+    forever {
+        int headerEnd = buffer.indexOf("\r\n\r\n");
+        if (headerEnd < 0) return;
+
+        int contentLength = 0;
+        for (const QByteArray &line : buffer.left(headerEnd).split('\n')) {
+            if (line.toLower().startsWith("content-length:")) {
+                contentLength = line.mid(15).trimmed().toInt();
+            }
+        }
+        int requestSize = headerEnd + 4 + contentLength;
+        if (buffer.size() < requestSize) return;
+
+        QJsonObject body = QJsonDocument::fromJson(buffer.mid(headerEnd + 4, contentLength)).object();
+        buffer.remove(0, requestSize);
+        ++requests;
+        emit requestReceived(body);
+
+        if (responseDelay > 0) {
+            QTimer::singleShot(responseDelay, socket, [this, socket, body]() { respond(socket, body); });
+        } else {
+            respond(socket, body);
+        }
+    }
+}
+
+void MockCompletionServer::respond(QTcpSocket *socket, const QJsonObject &request)
+{
+    int choiceCount = qMax(1, request["n"].toInt(1));
+    QJsonArray choices;
+    for (int i = 0; i < choiceCount; ++i) {
+        QJsonObject message;
+        message["role"] = "assistant";
+        message["content"] = completions.value(i % qMax(1, completions.size()));
+
+        QJsonObject choice;
+        choice["index"] = i;
+        choice["message"] = message;
+        choice["finish_reason"] = "stop";
+        choices.append(choice);
+    }
+
+    QJsonObject usage;
+    usage["prompt_tokens"] = 0;
+    usage["completion_tokens"] = choiceCount * 8;
+    usage["total_tokens"] = choiceCount * 8;
+
+    QJsonObject response;
+    response["id"] = QString("mock-%1").arg(requests);
+    response["object"] = "chat.completion";
+    response["model"] = request["model"].toString();
+    response["choices"] = choices;
+    response["usage"] = usage;
+
+    QByteArray body = QJsonDocument(response).toJson(QJsonDocument::Compact);
+    QByteArray reply = "HTTP/1.1 200 OK\r\n"
+                       "Content-Type: application/json\r\n"
+                       "Connection: keep-alive\r\n"
+                       "Content-Length: " + QByteArray::number(body.size()) + "\r\n\r\n" + body;
+    socket->write(reply);
+}
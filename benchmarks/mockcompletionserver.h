@@ -0,0 +1,50 @@
+#ifndef MOCKCOMPLETIONSERVER_H
+#define MOCKCOMPLETIONSERVER_H
+
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QSslCertificate>
+#include <QSslKey>
+#include <QJsonObject>
+#include <QStringList>
+#include <QHash>
+#include <QUrl>
+
+// Minimal local stand-in for the chat completions endpoint. Speaks HTTP/1.1 with
+// keep-alive, or HTTPS once a certificate is set, and answers every request with
+// canned choices after an optional delay.
+class MockCompletionServer : public QTcpServer
+{
+    Q_OBJECT
+
+public:
+    explicit MockCompletionServer(QObject *parent = nullptr);
+
+    bool start(quint16 port = 0);
+    QUrl url() const;
+    void setCompletions(const QStringList &completions);
+    void setResponseDelay(int ms);
+    void setTlsCertificate(const QSslCertificate &certificate, const QSslKey &key);
+    int requestCount() const;
+
+signals:
+    void requestReceived(const QJsonObject &body);
+
+protected:
+    void incomingConnection(qintptr socketDescriptor) override;
+
+private slots:
+    void readRequest();
+
+private:
+    void respond(QTcpSocket *socket, const QJsonObject &request);
+
+    QHash<QTcpSocket *, QByteArray> buffers;
+    QStringList completions;
+    QSslCertificate certificate;
+    QSslKey privateKey;
+    int responseDelay;
+    int requests;
+};
+
+#endif // MOCKCOMPLETIONSERVER_H
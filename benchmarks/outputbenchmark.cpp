@@ -0,0 +1,33 @@
+#include "benchmarks.h"
+#include "outputpane.h"
+#include <QTest>
+
+void OutputBenchmark::ingestLines_data()
+{
+    QTest::addColumn<int>("chunks");
+    QTest::addColumn<int>("linesPerChunk");
+    QTest::newRow("1000 single lines") << 1000 << 1;
+    QTest::newRow("100 chunks of 100 lines") << 100 << 100;
+}
+
+void OutputBenchmark::ingestLines()
+{
+    QFETCH(int, chunks);
+    QFETCH(int, linesPerChunk);
+
+    QStringList lines;
+    for (int i = 0; i < linesPerChunk; ++i) {
+        lines.append(QString("case %1: expected 42, got 42 (0.0%1 s)").arg(i));
+    }
+    const QString chunk = lines.join('\n');
+
+    // Simulates a program writing to stdout faster than the pane repaints
+    OutputPane pane;
+    QBENCHMARK {
+        pane.clearOutput();
+        for (int i = 0; i < chunks; ++i) {
+            pane.appendOutput(chunk);
+        }
+        pane.flush();
+    }
+}
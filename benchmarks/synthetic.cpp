@@ -0,0 +1,52 @@
+#include "synthetic.h"
+#include <QStringList>
+
+QString syntheticSource(int lines)
+{
+    static const char *const header[] = {
+        "#include <iostream>",
+        "#include <vector>",
+        "#include <string>",
+        "#include <algorithm>",
+        ""
+    };
+    static const char *const unit[] = {
+        "/* Record %1",
+        " * keeps a name and a running total */",
+        "class Record%1 {",
+        "private:",
+        "    std::string name;",
+        "    int total = %1;",
+        "",
+        "public:",
+        "    explicit Record%1(const std::string& n) : name(n) {}",
+        "",
+        "    int accumulate(const std::vector<int>& values) {",
+        "        for (int value : values) {",
+        "            total += value * 3 + (value >> 1);  // mix bits",
+        "        }",
+        "        return total;",
+        "    }",
+        "",
+        "    std::string describe() const { return name + \" #%1\"; }",
+        "};",
+        "",
+        "template<typename T>",
+        "T largest%1(const std::vector<T>& items) {",
+        "    if (items.empty()) throw std::runtime_error(\"empty input %1\");",
+        "    return *std::max_element(items.begin(), items.end());",
+        "}",
+        ""
+    };
+
+    QStringList out;
+    for (const char *line : header) {
+        out.append(QString::fromLatin1(line));
+    }
+    for (int i = 0; out.size() < lines; ++i) {
+        for (const char *line : unit) {
+            out.append(QString::fromLatin1(line).replace(QLatin1String("%1"), QString::number(i)));
+        }
+    }
+    return out.mid(0, lines).join('\n');
+}
@@ -0,0 +1,10 @@
+#ifndef SYNTHETIC_H
+#define SYNTHETIC_H
+
+#include <QString>
+
+// Generates a C++ translation unit of the given number of lines that mixes the
+// constructs the highlighter and context builder care about.
+QString syntheticSource(int lines);
+
+#endif // SYNTHETIC_H
@@ -0,0 +1,115 @@
+#include "benchmarks.h"
+#include "undohistory.h"
+#include "synthetic.h"
+#include <QTest>
+#include <QTextEdit>
+#include <QTextDocument>
+#include <QTextCursor>
+#include <QTextBlock>
+
+void UndoBenchmark::undoRedo_data()
+{
+    QTest::addColumn<int>("lines");
+    QTest::newRow("10k lines") << 10000;
+    QTest::newRow("100k lines") << 100000;
+}
+
+void UndoBenchmark::undoRedo()
+{
+    QFETCH(int, lines);
+    QTextEdit editor;
+    editor.setPlainText(syntheticSource(lines));
+    UndoHistory history(&editor);
+
+    // Edits spread over the file, so each is its own step and most get packed
+    for (int i = 0; i < 1000; ++i) {
+        QTextCursor cursor(editor.document()->findBlockByNumber((i * 7919) % lines));
+        cursor.insertText("x");
+    }
+    QVERIFY(history.canUndo());
+
+    QBENCHMARK {
+        for (int i = 0; i < 100; ++i) history.undo();
+        for (int i = 0; i < 100; ++i) history.redo();
+    }
+    QVERIFY(history.memoryUsage() > 0);
+}
+
+void UndoBenchmark::typeKeystrokes_data()
+{
+    QTest::addColumn<int>("lines");
+    QTest::newRow("10k lines") << 10000;
+    QTest::newRow("100k lines") << 100000;
+}
+
+void UndoBenchmark::typeKeystrokes()
+{
+    QFETCH(int, lines);
+    QTextEdit editor;
+    editor.setPlainText(syntheticSource(lines));
+    UndoHistory history(&editor);
+
+    // Recording a keystroke copies only the delta into the history
+    QTextCursor cursor(editor.document()->findBlockByNumber(lines / 2));
+    QBENCHMARK {
+        cursor.insertText("x");
+    }
+    QVERIFY(history.canUndo());
+}
+
+void UndoBenchmark::roundTrip()
+{
+    const int lines = 2000;
+    QTextEdit editor;
+    editor.setPlainText(syntheticSource(lines));
+    UndoHistory history(&editor);
+    QTextDocument *doc = editor.document();
+
+    // Inserts, removals and replacements spread over the file; the inserts are large
+    // enough to be packed once they leave the hot window
+    QString afterFirst;
+    QString beforeLast;
+    const int edits = 2 * UndoHistory::HOT_STEPS + 8;
+    for (int i = 0; i < edits; ++i) {
+        if (i == edits - 1) beforeLast = doc->toPlainText();
+        QTextCursor cursor(doc->findBlockByNumber((i * 7919) % lines));
+        if (i % 3 == 0) {
+            cursor.insertText(QString("chunk%1 ").arg(i).repeated(30));
+        } else if (i % 3 == 1) {
+            // The whole line with its break, so even a blank line is a change
+            cursor.movePosition(QTextCursor::NextBlock, QTextCursor::KeepAnchor);
+            cursor.removeSelectedText();
+        } else {
+            cursor.movePosition(QTextCursor::EndOfBlock, QTextCursor::KeepAnchor);
+            cursor.insertText(QString("// replaced %1\nint line%1 = %1;").arg(i));
+        }
+        if (i == 0) afterFirst = doc->toPlainText();
+    }
+    const QString edited = doc->toPlainText();
+
+    // Typing and backspacing over it again leaves no step behind
+    QTextCursor typing(doc);
+    typing.insertText("a");
+    typing.insertText("b");
+    typing.deletePreviousChar();
+    typing.deletePreviousChar();
+    QCOMPARE(doc->toPlainText(), edited);
+    history.undo();
+    QCOMPARE(doc->toPlainText(), beforeLast);
+    history.redo();
+    QCOMPARE(doc->toPlainText(), edited);
+
+    // Just under the current usage, so the oldest step is dropped
+    history.setMemoryLimit(history.memoryUsage() - 1);
+
+    int undone = 0;
+    while (history.canUndo()) {
+        history.undo();
+        ++undone;
+    }
+    QCOMPARE(undone, edits - 1);
+    QCOMPARE(doc->toPlainText(), afterFirst);
+
+    while (history.canRedo()) history.redo();
+    QCOMPARE(doc->toPlainText(), edited);
+}
@@ -0,0 +1,60 @@
+# Editor sources shared by the application and the benchmark suite
+QT       += core gui network concurrent
+
+greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
+
+CONFIG += c++17
+
+INCLUDEPATH += $$PWD/include/
+
+# Source files
+SOURCES += \
+    $$PWD/src/mainwindow.cpp \
+    $$PWD/src/completionwidget.cpp \
+    $$PWD/src/highlighter.cpp \
+    $$PWD/src/contextbuilder.cpp \
+    $$PWD/src/completionclient.cpp \
+    $$PWD/src/settings.cpp \
+    $$PWD/src/sourcefile.cpp \
+    $$PWD/src/outputpane.cpp \
+    $$PWD/src/judgerunner.cpp \
+    $$PWD/src/outputcomparator.cpp \
+    $$PWD/src/inputfeeder.cpp \
+    $$PWD/src/precompiledheader.cpp \
+    $$PWD/src/assemblyview.cpp \
+    $$PWD/src/benchmarkharness.cpp \
+    $$PWD/src/scopeindex.cpp \
+    $$PWD/src/codefolding.cpp \
+    $$PWD/src/undohistory.cpp \
+    $$PWD/src/projectreplace.cpp \
+    $$PWD/src/replacepanel.cpp \
+    $$PWD/src/sessionstore.cpp \
+    $$PWD/src/completiontelemetry.cpp
+
+# Header files
+HEADERS += \
+    $$PWD/include/mainwindow.h \
+    $$PWD/include/completionwidget.h \
+    $$PWD/include/highlighter.h \
+    $$PWD/include/contextbuilder.h \
+    $$PWD/include/completionclient.h \
+    $$PWD/include/settings.h \
+    $$PWD/include/sourcefile.h \
+    $$PWD/include/outputpane.h \
+    $$PWD/include/judgerunner.h \
+    $$PWD/include/outputcomparator.h \
+    $$PWD/include/inputfeeder.h \
+    $$PWD/include/precompiledheader.h \
+    $$PWD/include/assemblyview.h \
+    $$PWD/include/benchmarkharness.h \
+    $$PWD/include/scopeindex.h \
+    $$PWD/include/codefolding.h \
+    $$PWD/include/undohistory.h \
+    $$PWD/include/projectreplace.h \
+    $$PWD/include/replacepanel.h \
+    $$PWD/include/sessionstore.h \
+    $$PWD/include/completiontelemetry.h
+
+# Forms
+FORMS += \
+    $$PWD/resources/mainwindow.ui
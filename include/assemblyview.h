@@ -0,0 +1,79 @@
+#ifndef ASSEMBLYVIEW_H
+#define ASSEMBLYVIEW_H
+
+#include <QPlainTextEdit>
+#include <QProcess>
+#include <QFutureWatcher>
+#include <QStringList>
+#include <QVector>
+#include <QHash>
+#include <QTimer>
+
+// Compiler assembly output with directives filtered out, symbols demangled and
+// every instruction tagged with the source line it came from (0 when unknown).
+struct AssemblyListing
+{
+    QStringList lines;
+    QVector<int> sourceLines;
+    QHash<int, QVector<int>> linesForSource;  // Source line -> listing lines
+
+    static AssemblyListing parse(const QString &assembly, const QString &sourceFile);
+};
+
+// Read-only pane showing the assembly of the current file. Compilation and
+// parsing run in the background and the text is inserted in slices, so large
+// listings never stall the editor.
+class AssemblyView : public QPlainTextEdit
+{
+    Q_OBJECT
+
+public:
+    explicit AssemblyView(QWidget *parent = nullptr);
+    ~AssemblyView();
+
+    // Recompiles only when the source, compiler or flags differ from the last refresh
+    void refresh(const QString &compiler, const QStringList &flags,
+                 const QString &sourceFile, const QString &sourceText);
+
+public slots:
+    void highlightSourceLine(int line);
+
+signals:
+    void sourceLineSelected(int line);
+    void statusChanged(const QString &message);
+
+private slots:
+    void compileFinished(int exitCode, QProcess::ExitStatus exitStatus);
+    void parseFinished();
+    void insertSlice();
+    void selectionMoved();
+
+private:
+    struct Request
+    {
+        QByteArray key;
+        QString compiler;
+        QStringList arguments;
+        QString sourceFile;
+    };
+
+    void startCompile(const Request &request);
+    bool isBusy() const;
+    void applyHighlight(bool scroll);
+
+    QProcess *process;
+    QFutureWatcher<AssemblyListing> *parseWatcher;
+    QTimer *sliceTimer;
+    AssemblyListing listing;
+    int insertedLines;
+    int highlightedSource;
+
+    QByteArray shownKey;
+    Request current;
+    Request queued;
+    bool refreshQueued;
+
+    static const int SLICE_LINES = 2000;  // Listing lines inserted per event loop pass
+};
+
+#endif // ASSEMBLYVIEW_H
@@ -0,0 +1,30 @@
+#ifndef BENCHMARKHARNESS_H
+#define BENCHMARKHARNESS_H
+
+#include <QString>
+#include <QStringList>
+
+// Generates a self-timing program around an expression from the current file.
+// The file is included with its main() renamed, so the expression can use any
+// function or type declared at file scope.
+class BenchmarkHarness
+{
+public:
+    // Name of the function defined by the selection, or an empty string;
+    // hasParameters tells whether a call needs arguments from the user
+    static QString functionName(const QString &selection, bool *hasParameters = nullptr);
+
+    // Splits a snippet at its last top-level ';' into setup statements and the timed expression
+    static void splitSnippet(const QString &snippet, QString *setup, QString *expression);
+
+    static QString generate(const QString &sourceFile, const QString &setup, const QString &expression);
+
+    // Whether the flags enable optimization; timings of -O0 builds are rarely meaningful
+    static bool optimizes(const QStringList &flags);
+
+    static const int SAMPLES = 30;  // The harness's t value assumes 29 degrees of freedom
+    static const int SAMPLE_TARGET_US = 10000;  // Calibrated duration of one sample
+    static const int WARMUP_US = 100000;
+};
+
+#endif // BENCHMARKHARNESS_H
@@ -0,0 +1,43 @@
+#ifndef CODEFOLDING_H
+#define CODEFOLDING_H
+
+#include <QObject>
+#include <QTextEdit>
+#include <QTextBlock>
+#include <QList>
+#include "scopeindex.h"
+
+// Collapses brace scopes by hiding their inner blocks from the document layout.
+// The line that opens a scope and the line that closes it stay visible.
+class CodeFolding : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit CodeFolding(QTextEdit *editor, QObject *parent = nullptr);
+
+    // Marks for the visible lines that hide a folded scope
+    QList<QTextEdit::ExtraSelection> selections() const;
+
+public slots:
+    void toggleFoldAtCursor();
+    void foldAll();
+    void unfoldAll();
+
+signals:
+    void foldsChanged();
+
+private slots:
+    void contentsChanged(int position, int charsRemoved, int charsAdded);
+
+private:
+    bool fold(const QTextBlock &start);
+    void unfold(const QTextBlock &start);
+    void showRange(QTextBlock from, const QTextBlock &to);
+    void relayout(const QTextBlock &from, const QTextBlock &to);
+
+    QTextEdit *editor;
+    ScopeIndex *index;
+};
+
+#endif // CODEFOLDING_H
@@ -0,0 +1,155 @@
+#ifndef COMPLETIONCLIENT_H
+#define COMPLETIONCLIENT_H
+
+#include <QObject>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QSslConfiguration>
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QTimer>
+#include <QHash>
+#include <QVector>
+#include <QUrl>
+
+struct RequestTiming
+{
+    qint64 connectMs = -1;  // TCP+TLS setup, -1 when a warm connection was reused;
+                            // over plain http, until the request started going out
+    qint64 ttfbMs = -1;     // Until response headers arrived
+    qint64 totalMs = -1;    // From send() to the final reply, including retries
+    bool http2 = false;
+    int attempts = 0;
+    bool hedged = false;    // The winning reply came from the alternate endpoint
+};
+Q_DECLARE_METATYPE(RequestTiming)
+
+// Owns the HTTP session to the completion endpoint and keeps it warm between requests.
+// Requests get a deadline, retries with jittered backoff, optional hedging to an
+// alternate endpoint and a circuit breaker; when a request cannot be served
+// requestFailed() is emitted so the caller can fall back to a local completion.
+class CompletionClient : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum KeepWarmPolicy {
+        NoKeepWarm,     // Connect lazily on the first request
+        WarmOnStartup,  // Pre-connect once at startup
+        KeepWarm        // Pre-connect at startup and again after every idle period
+    };
+
+    enum Priority {
+        Interactive,  // The user is waiting for it
+        Speculative   // Prefetch: low network priority, no retries or hedging, dropped unless healthy
+    };
+
+    enum CircuitState {
+        CircuitClosed,   // Requests flow normally
+        CircuitOpen,     // Too many failures, requests fail fast
+        CircuitHalfOpen  // Cooldown elapsed, one probe request allowed
+    };
+
+    explicit CompletionClient(QObject *parent = nullptr);
+
+    void setEndpoint(const QUrl &url);
+    QUrl endpoint() const;
+    void setAlternateEndpoint(const QUrl &url);
+    QUrl alternateEndpoint() const;
+    void setApiKey(const QString &key);
+    void setKeepWarmPolicy(KeepWarmPolicy policy, int idleMs = DEFAULT_IDLE_MS);
+    KeepWarmPolicy keepWarmPolicy() const;
+    void setSslConfiguration(const QSslConfiguration &config);
+    void setDeadline(int ms);
+    void setMaxAttempts(int attempts);
+    void setHedgingEnabled(bool enabled);
+    void setCircuitBreaker(int failureThreshold, int cooldownMs);
+    CircuitState circuitState() const;
+
+    // Posts a chat completion request and returns its id. A speculative request
+    // returns 0 instead when the circuit is not closed.
+    quint64 send(const QJsonObject &body, Priority priority = Interactive);
+
+    static const QString DEFAULT_ENDPOINT;
+    static const int DEFAULT_IDLE_MS = 60000;
+    static const int DEFAULT_DEADLINE_MS = 5000;
+    static const int DEFAULT_MAX_ATTEMPTS = 3;
+    static const int DEFAULT_HEDGE_MS = 1500;  // Used until enough latency samples exist
+    static const int DEFAULT_FAILURE_THRESHOLD = 5;
+    static const int DEFAULT_COOLDOWN_MS = 30000;
+
+public slots:
+    void prewarm();
+
+signals:
+    void replyReceived(quint64 id, const QJsonObject &response, const RequestTiming &timing);
+    void requestFailed(quint64 id, int statusCode, const QString &error, const RequestTiming &timing);
+    void circuitStateChanged(CompletionClient::CircuitState state);
+
+private slots:
+    void handleFinished(QNetworkReply *reply);
+    void handleEncrypted(QNetworkReply *reply);
+
+private:
+    struct Attempt
+    {
+        quint64 id;
+        QElapsedTimer timer;
+        RequestTiming timing;
+        bool hedge;
+    };
+
+    struct PendingRequest
+    {
+        QJsonObject body;
+        QElapsedTimer started;
+        int attempts = 0;
+        bool hedged = false;
+        bool probe = false;
+        bool speculative = false;
+        QList<QNetworkReply *> replies;
+    };
+
+    void startAttempt(quint64 id, bool hedge);
+    bool scheduleRetry(quint64 id, int retryAfterMs);
+    void complete(quint64 id, const QJsonObject &response, const RequestTiming &timing);
+    void fail(quint64 id, int statusCode, const QString &error, const RequestTiming &timing);
+    void recordOutcome(bool success);
+    void setCircuitState(CircuitState state);
+    bool allowRequest();
+    int hedgeThreshold() const;
+    void connectTo(const QUrl &url);
+    static bool isRetryable(QNetworkReply *reply);
+
+    QNetworkAccessManager *networkManager;
+    QTimer *idleTimer;
+    QHash<QNetworkReply *, Attempt> attempts;
+    QHash<quint64, PendingRequest> requests;
+    QUrl endpointUrl;
+    QUrl alternateUrl;
+    QString apiKey;
+    QSslConfiguration sslConfig;
+    KeepWarmPolicy policy;
+    quint64 nextId;
+
+    int deadlineMs;
+    int maxAttempts;
+    bool hedgingEnabled;
+    QVector<qint64> latencySamples;  // Ring buffer of recent primary latencies
+    int nextSample;
+
+    CircuitState circuit;
+    int consecutiveFailures;
+    int failureThreshold;
+    int cooldownMs;
+    QElapsedTimer circuitOpened;
+    bool probeInFlight;
+    bool requestedSinceWarm;  // A request was sent since the last pre-connect
+
+    static const int LATENCY_SAMPLES = 100;
+    static const int MIN_HEDGE_SAMPLES = 20;
+    static const int BASE_BACKOFF_MS = 200;
+    static const int MAX_BACKOFF_MS = 2000;
+};
+
+#endif // COMPLETIONCLIENT_H
@@ -0,0 +1,91 @@
+#ifndef COMPLETIONTELEMETRY_H
+#define COMPLETIONTELEMETRY_H
+
+#include <QObject>
+#include <QFile>
+#include <QElapsedTimer>
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+// One completion from trigger to outcome. Latencies are -1 when they do not apply.
+struct CompletionEvent
+{
+    enum Source { Network, Cache, Local };
+    enum Trigger { TypingPause, NewLine, IdleAtLineEnd };
+    enum Outcome { Accepted, Dismissed, NotShown, Failed };
+
+    quint64 session = 0;      // Random id per telemetry instance, i.e. per run
+    qint64 elapsedMs = 0;     // Trigger time since the session started
+    qint64 timestamp = 0;     // Trigger time in ms since the epoch
+    QByteArray contextHash;   // SHA-1 of the model and cache key of the context
+    QString backend;          // "model@host"
+    quint8 source = Network;
+    quint8 trigger = TypingPause;
+    bool speculative = false;
+    qint32 queueMs = -1;      // Trigger to request sent
+    qint32 connectMs = -1;
+    qint32 ttfbMs = -1;
+    qint32 totalMs = -1;      // Request sent to final reply
+    qint32 attempts = 0;
+    qint32 promptTokens = -1;
+    qint32 completionTokens = -1;
+    qint32 statusCode = 0;    // Of a failed request
+    quint8 outcome = NotShown;
+    qint32 candidates = 0;
+    qint32 acceptedIndex = -1;
+    QString prefix;           // Text around the cursor, only recorded for replay
+    QString suffix;
+};
+
+// Appends completion events to a rotating binary log: completions.log is
+// renamed to completions.log.1 (and older files shifted up) once it passes
+// MAX_LOG_BYTES, and at most MAX_LOG_FILES files are kept.
+class CompletionTelemetry : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Mode {
+        Off,
+        Metrics,  // Timing, tokens and outcome only
+        Replay    // Also the text around the cursor, so the session can be replayed
+    };
+
+    explicit CompletionTelemetry(QObject *parent = nullptr);
+
+    void setMode(Mode mode);
+    Mode mode() const;
+    void setDirectory(const QString &directory);
+    QString directory() const;
+
+    // Fills in the session and trigger times of a new event
+    void start(CompletionEvent *event) const;
+    void record(const CompletionEvent &event);
+
+    static QString defaultDirectory();
+    // The events of every log in the directory, oldest first
+    static QVector<CompletionEvent> readDirectory(const QString &directory);
+    static bool readLog(const QString &path, QVector<CompletionEvent> *events);
+
+    static const int MAX_LOG_BYTES = 4 * 1024 * 1024;
+    static const int MAX_LOG_FILES = 4;
+    static const int MAX_PREFIX_CHARS = 4096;  // Context kept for replay
+    static const int MAX_SUFFIX_CHARS = 1024;
+
+private:
+    bool openLog();
+    void rotate();
+    QString logPath(int index) const;
+
+    Mode logMode;
+    QString logDirectory;
+    QFile log;
+    quint64 session;
+    QElapsedTimer sessionTimer;
+
+    static const quint32 LOG_MAGIC = 0x42434c47;  // "BCLG"
+    static const quint16 LOG_VERSION = 1;
+};
+
+#endif // COMPLETIONTELEMETRY_H
@@ -3,10 +3,15 @@
 
 #include <QFrame>
 #include <QTextEdit>
-#include <QNetworkAccessManager>
-#include <QNetworkReply>
 #include <QTimer>
 #include <QString>
+#include <QCache>
+#include <QHash>
+#include <QSet>
+#include <QElapsedTimer>
+#include "contextbuilder.h"
+#include "completionclient.h"
+#include "completiontelemetry.h"
 
 class CompletionWidget : public QFrame
 {
@@ -15,14 +20,19 @@ class CompletionWidget : public QFrame
 public:
     explicit CompletionWidget(QTextEdit *parent = nullptr);
     void showCompletion(const QString &completion);
+    void showCandidates(const QStringList &candidates);
     void hideCompletion();
     bool isVisible() const;
     QString currentCompletion() const;
+    void cycleCandidate(int step);
     void setModel(const QString &model);
     QString currentModel() const;
+    QStringList availableModels() const;
+    void setContextTokenBudget(int tokens);
+    // Runs the completion pipeline as if the trigger had just happened in the editor
+    void triggerCompletion(CompletionEvent::Trigger trigger);
 
-    static const QString DEFAULT_MODEL;
-    static const QStringList AVAILABLE_MODELS;
+    static const int DEFAULT_SPECULATION_BUDGET = 10000;  // Tokens per minute
 
 signals:
     void modelChanged(const QString &model);
@@ -32,22 +42,66 @@ protected:
     bool eventFilter(QObject *obj, QEvent *event) override;
 
 private slots:
-    void handleNetworkReply(QNetworkReply *reply);
+    void handleCompletionReply(quint64 id, const QJsonObject &response, const RequestTiming &timing);
+    void handleCompletionFailure(quint64 id, int statusCode, const QString &error, const RequestTiming &timing);
     void requestCompletion();
+    void speculate();
+    void applySettings();
 
 private:
+    struct CachedCompletion
+    {
+        QStringList candidates;
+        QElapsedTimer age;
+    };
+
+    QJsonObject requestBody(const QString &prompt) const;
+    QByteArray cacheKey(const QString &typedAhead = QString()) const;
+    QStringList cachedCandidates(const QByteArray &key);
+    bool showCached();
+    void prefetch(const QString &typedAhead);
+    bool takeSpeculationBudget(int tokens);
     void updatePosition();
-    QString getContextAroundCursor();
     void setupStyle();
-    QString createPrompt(const QString &context);
+    static QStringList rankCandidates(const QStringList &suggestions);
+    QStringList localCandidates() const;
+    CompletionEvent newEvent(const QByteArray &key, bool speculative) const;
+    void captureContext(CompletionEvent *event) const;
+    void showRecorded(const CompletionEvent &event, const QStringList &suggestions);
+    void finishShown(CompletionEvent::Outcome outcome);
 
     QTextEdit *editor;
     QString completion;
-    QNetworkAccessManager *networkManager;
+    QStringList candidates;
+    int candidateIndex;
+    CompletionClient *client;
     QTimer *completionTimer;
     QString model;
-    static const int CONTEXT_CHARS = 500;  // Characters to consider before cursor
+    ContextBuilder *contextBuilder;
+    QTimer *speculationTimer;
+    QCache<QByteArray, CachedCompletion> cache;
+    QHash<quint64, QByteArray> requestKeys;  // Context key of each request in flight
+    QSet<quint64> speculativeRequests;
+    int speculationBudget;  // Tokens per minute, 0 disables speculation
+    double budgetTokens;
+    QElapsedTimer budgetRefill;
+    int speculations;
+    int cacheHits;
+    quint64 latestInteractive;  // Replies to older interactive requests are not shown
+    CompletionTelemetry *telemetry;
+    CompletionEvent triggerEvent;  // Session time and context of the latest trigger
+    QElapsedTimer triggered;
+    QHash<quint64, CompletionEvent> pendingEvents;  // Telemetry of each request in flight
+    CompletionEvent shownEvent;  // Recorded once the suggestion on screen is accepted or dismissed
+    bool showingEvent;
+
     static const int COMPLETION_DELAY = 750;  // Milliseconds to wait before requesting
+    static const int CANDIDATE_COUNT = 3;  // Alternatives requested per completion
+    static const int MAX_COMPLETION_TOKENS = 50;
+    static const int SPECULATION_IDLE_MS = 400;  // Pause at a line end before prefetching
+    static const int CACHE_ENTRIES = 64;
+    static const int CACHE_TTL_MS = 300000;  // Older suggestions are likely stale
+    static const int LOCAL_SCAN_LINES = 500;  // Lines each side of the cursor searched for local completions
 };
 
 #endif // COMPLETIONWIDGET_H
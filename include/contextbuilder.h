@@ -0,0 +1,79 @@
+#ifndef CONTEXTBUILDER_H
+#define CONTEXTBUILDER_H
+
+#include <QObject>
+#include <QTextEdit>
+#include <QTextCursor>
+#include <QTextBlock>
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include "scopeindex.h"
+
+// Approximates the token count of a BPE tokenizer (cl100k-style pre-tokenization)
+// locally, so prompts can be sized without a round trip.
+class TokenCounter
+{
+public:
+    static int count(const QString &text);
+};
+
+class ContextBuilder : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ContextBuilder(QTextEdit *editor, QObject *parent = nullptr);
+
+    void setTokenBudget(int tokens);
+    int tokenBudget() const;
+    int lastPromptTokens() const;
+
+    // Packs the cursor neighbourhood and supporting context into the token budget;
+    // typedAhead is treated as if it had already been typed at the cursor
+    QString buildPrompt(const QString &typedAhead = QString());
+
+    // Hash of the lines around the cursor (with typedAhead inserted). Unlike the
+    // prompt it ignores recent edits, so a context predicted ahead of time and the
+    // one the user then arrives at hash the same.
+    QByteArray contextKey(const QString &typedAhead = QString()) const;
+
+    static const int DEFAULT_TOKEN_BUDGET = 1024;
+    static const int MIN_CONTEXT_TOKENS = 64;  // Budget kept beyond the instruction, for the cursor line
+
+private slots:
+    void recordEdit(int position, int charsRemoved, int charsAdded);
+
+private:
+    struct Declaration
+    {
+        int blockNumber;
+        QString text;
+        int tokens;
+        int score;
+    };
+
+    QString takePrefix(const QTextCursor &cursor, int maxTokens, int *firstBlock) const;
+    QString takeSuffix(const QTextCursor &cursor, int maxTokens, int *lastBlock) const;
+    QString enclosingSignature(const QTextCursor &cursor, int *blockNumber) const;
+    QString headBefore(const QTextBlock &block, int position, int *blockNumber) const;
+    QString takeDeclarations(const QString &prefix, int firstBlock, int lastBlock, int maxTokens);
+    QString takeRecentEdits(int firstBlock, int lastBlock, int maxTokens) const;
+    void updateDeclarations();
+
+    QTextEdit *editor;
+    ScopeIndex *scopes;
+    int budget;
+    int promptTokens;
+    QList<QTextCursor> recentEdits;
+    QList<Declaration> declarations;
+    int declarationsRevision;
+
+    static const QString INSTRUCTION;
+    static const int MAX_RECENT_EDITS = 8;
+    static const int MAX_SIGNATURE_CHARS = 300;
+    static const int KEY_PREFIX_LINES = 6;  // Lines before the cursor line in the context key
+    static const int KEY_SUFFIX_LINES = 2;
+};
+
+#endif // CONTEXTBUILDER_H
@@ -4,6 +4,8 @@
 #include <QSyntaxHighlighter>
 #include <QTextCharFormat>
 #include <QRegularExpression>
+#include <QVector>
+#include <QTimer>
 
 class Highlighter : public QSyntaxHighlighter
 {
@@ -12,9 +14,22 @@ class Highlighter : public QSyntaxHighlighter
 public:
     explicit Highlighter(QTextDocument *parent = nullptr);
 
+    // Before loading text whose block states are known: blocks outside
+    // [firstBlock, lastBlock] then only take their state, and finishRestore()
+    // formats and checks them in slices from the event loop
+    void restoreStates(const QVector<int> &states, int firstBlock, int lastBlock);
+    void finishRestore();
+    QVector<int> blockStates() const;
+
+    static const int RESTORE_SLICE_BLOCKS = 500;  // Deferred blocks formatted per event loop pass
+
 protected:
     void highlightBlock(const QString &text) override;
 
+private slots:
+    void formatDeferred();
+    void contentsChanged(int position, int charsRemoved, int charsAdded);
+
 private:
     struct HighlightingRule
     {
@@ -35,6 +50,14 @@ private:
 
     QRegularExpression commentStartExpression;
     QRegularExpression commentEndExpression;
+
+    QVector<int> restoredStates;
+    bool restoring;
+    int restoreFirst;
+    int restoreLast;
+    int deferredNext;  // Next block the deferred pass formats, -1 when idle
+    int mismatches;    // Restored states the deferred pass found to be wrong
+    QTimer *deferredTimer;
 };
 
 #endif
@@ -0,0 +1,46 @@
+#ifndef INPUTFEEDER_H
+#define INPUTFEEDER_H
+
+#include <QObject>
+#include <QProcess>
+#include <QFile>
+#include <QByteArray>
+
+// Streams an input file into a process's stdin in bounded chunks, topping the
+// write buffer up from bytesWritten so memory stays flat for any input size.
+// Interactive lines are queued behind the file and sent in order.
+class InputFeeder : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit InputFeeder(QProcess *process, QObject *parent = nullptr);
+
+    // Call after QProcess::start(); feeding begins once the process is running
+    bool feedFile(const QString &fileName, QString *error = nullptr);
+    void sendLine(const QString &line);
+    void closeInput();
+    void stop();
+
+    bool isFeedingFile() const;
+
+    static const qint64 CHUNK_SIZE = 64 * 1024;
+    static const qint64 HIGH_WATER = 1024 * 1024;  // Bytes allowed in QProcess's write buffer
+
+signals:
+    void progress(qint64 sent, qint64 total);
+    void fileFinished();
+
+private slots:
+    void writeMore();
+
+private:
+    QProcess *process;
+    QFile input;
+    QByteArray queuedLines;
+    qint64 sent;
+    int lastPercent;
+    bool closeWhenDone;
+};
+
+#endif // INPUTFEEDER_H
@@ -0,0 +1,81 @@
+#ifndef JUDGERUNNER_H
+#define JUDGERUNNER_H
+
+#include <QObject>
+#include <QThreadPool>
+#include <QString>
+#include <QList>
+#include <atomic>
+#include <memory>
+
+struct JudgeCase
+{
+    QString name;
+    QString inputPath;
+    QString expectedPath;
+};
+
+struct JudgeResult
+{
+    enum Verdict {
+        Accepted,
+        WrongAnswer,
+        TimeLimitExceeded,
+        MemoryLimitExceeded,
+        RuntimeError,
+        InternalError
+    };
+
+    QString name;
+    Verdict verdict = InternalError;
+    qint64 timeMs = 0;     // CPU time of the child
+    qint64 peakRssKb = 0;
+    QString detail;
+
+    QString verdictCode() const;
+};
+Q_DECLARE_METATYPE(JudgeResult)
+
+// Runs a compiled program against input/expected-output pairs in parallel,
+// each case under its own CPU time and address space limits.
+class JudgeRunner : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit JudgeRunner(QObject *parent = nullptr);
+    ~JudgeRunner();
+
+    // Pairs every <name>.in in the directory with <name>.out, <name>.ans or <name>.expected
+    static QList<JudgeCase> discoverCases(const QString &directory);
+
+    void setTimeLimit(int ms);
+    void setMemoryLimit(int megabytes);
+    void start(const QString &program, const QList<JudgeCase> &cases);
+    void cancel();
+    bool isRunning() const;
+
+    static const int DEFAULT_TIME_LIMIT_MS = 2000;
+    static const int DEFAULT_MEMORY_LIMIT_MB = 256;
+
+signals:
+    void caseFinished(const JudgeResult &result);
+    void finished(int passed, int total);
+
+private:
+    static JudgeResult runCase(const QString &program, const JudgeCase &testCase,
+                               int timeLimitMs, int memoryLimitMb, const std::atomic_bool &cancelled);
+    void handleResult(const JudgeResult &result);
+
+    QThreadPool *pool;
+    std::shared_ptr<std::atomic_bool> cancelled;
+    int timeLimitMs;
+    int memoryLimitMb;
+    int total;
+    int completed;
+    int passed;
+
+    static const int WAIT_POLL_MAX_MS = 20;  // Longest sleep between checks for the child's exit
+};
+
+#endif // JUDGERUNNER_H
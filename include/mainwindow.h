@@ -5,8 +5,19 @@
 #include <QTextEdit>
 #include <QProcess>
 #include <QActionGroup>
+#include <QLineEdit>
+#include <QElapsedTimer>
+#include <QDockWidget>
 #include "completionwidget.h"
 #include "highlighter.h"
+#include "outputpane.h"
+#include "judgerunner.h"
+#include "inputfeeder.h"
+#include "precompiledheader.h"
+#include "assemblyview.h"
+#include "codefolding.h"
+#include "undohistory.h"
+#include "replacepanel.h"
 
 class MainWindow : public QMainWindow
 {
@@ -16,39 +27,96 @@ public:
     MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
 
+    static const int RESTORE_MARGIN_BLOCKS = 100;  // Blocks around the restored view highlighted up front
+
+protected:
+    void closeEvent(QCloseEvent *event) override;
+
 private slots:
     void newFile();
     void openFile();
     void saveFile();
     void saveFileAs();
     void compileAndRun();
+    void runTestCases();
+    void benchmarkSelection();
+    void chooseRunInput();
+    void clearRunInput();
+    void sendConsoleLine();
+    void closeProgramInput();
+    void inputProgress(qint64 sent, qint64 total);
+    void judgeCaseFinished(const JudgeResult &result);
+    void judgeFinished(int passed, int total);
     void processFinished(int exitCode, QProcess::ExitStatus exitStatus);
     void processError(QProcess::ProcessError error);
     void readCompilerOutput();
-    void setCompletionModel();
+    void setCompletionModel(QAction *action);
+    void populateModelMenu();
+    void setBuildProfile(QAction *action);
+    void settingsChanged();
+    void editorCursorMoved();
+    void highlightEditorLine(int line);
+    void openMatch(const QString &path, int line);
     void documentWasModified();
 
 private:
+    enum RunMode { RunProgram, RunJudge, RunBenchmark };
+
     void createActions();
     void createMenus();
     void setupEditor();
     bool maybeSave();
-    void loadFile(const QString &fileName);
+    void loadFile(const QString &fileName, int firstVisibleBlock = 0, int lastVisibleBlock = -1);
+    void restoreSession();
+    void saveHighlightStates();
     bool saveFile(const QString &fileName);
     void setCurrentFile(const QString &fileName);
+    void startBuild(RunMode mode, const QString &source);
+    void compileSource();
     void runCompiledProgram();
+    void runJudge();
     void createModelMenu();
+    void populateProfileMenu();
+    void refreshAssembly();
+    void updateExtraSelections();
 
     QTextEdit *editor;
-    QTextEdit *compilerOutput;
+    OutputPane *compilerOutput;
+    QLineEdit *consoleInput;
     QString currentFile;
     QProcess *process;
     bool isUntitled;
     bool isCompiling;
+    bool buildingHeader;
+    QString buildCompiler;
+    QStringList buildFlags;
+    PrecompiledHeader header;
+    QElapsedTimer buildTimer;
+    RunMode runMode;
+    QString buildSource;
+    QString buildOutput;
+    QString benchmarkExpression;
+    QString judgeDirectory;
+    JudgeRunner *judgeRunner;
+    InputFeeder *inputFeeder;
+    QString runInputFile;
+    QAction *clearInputAct;
     CompletionWidget *completionWidget;
     QMenu *modelMenu;
     QActionGroup *modelActionGroup;
+    QMenu *profileMenu;
+    QActionGroup *profileActionGroup;
+    QString activeProfile;
     Highlighter *highlighter;
+    CodeFolding *folding;
+    UndoHistory *undoHistory;
+    QList<QTextEdit::ExtraSelection> foldSelections;
+    QList<QTextEdit::ExtraSelection> assemblySelections;
+    QList<QTextEdit::ExtraSelection> bracketSelections;
+    AssemblyView *assemblyView;
+    QDockWidget *assemblyDock;
+    ReplacePanel *replacePanel;
+    QDockWidget *replaceDock;
 };
 
 #endif
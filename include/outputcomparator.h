@@ -0,0 +1,43 @@
+#ifndef OUTPUTCOMPARATOR_H
+#define OUTPUTCOMPARATOR_H
+
+#include <QFile>
+#include <QString>
+
+// Compares program output with the expected file as both stream in, ignoring
+// differences in whitespace. Neither side is ever held in memory as a whole.
+class OutputComparator
+{
+public:
+    explicit OutputComparator(const QString &expectedPath);
+
+    bool isOpen() const { return opened; }
+    bool hasMismatch() const { return mismatch; }
+    // 1-based index of the first token that differs
+    qint64 mismatchToken() const { return tokenIndex; }
+
+    void feed(const char *data, qint64 size);
+    // Call once the output has ended; leftover expected tokens are a mismatch
+    void finish();
+
+private:
+    static bool isSpace(char c);
+    void match(char c);
+    int nextRaw();
+    int nextExpected();
+
+    QFile expected;
+    char buffer[64 * 1024];
+    qint64 position;
+    qint64 length;
+    int held;
+    bool actualStarted;
+    bool actualSpace;
+    bool expectedStarted;
+    bool expectedSpace;
+    qint64 tokenIndex;
+    bool mismatch;
+    bool opened;
+};
+
+#endif // OUTPUTCOMPARATOR_H
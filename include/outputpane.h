@@ -0,0 +1,28 @@
+#ifndef OUTPUTPANE_H
+#define OUTPUTPANE_H
+
+#include <QTextEdit>
+#include <QStringList>
+#include <QTimer>
+
+// Read-only output pane that coalesces bursts of process output into one
+// document update per frame instead of one per read.
+class OutputPane : public QTextEdit
+{
+    Q_OBJECT
+
+public:
+    explicit OutputPane(QWidget *parent = nullptr);
+    void appendOutput(const QString &text);
+    void clearOutput();
+
+public slots:
+    void flush();
+
+private:
+    QStringList pending;
+    QTimer *flushTimer;
+    static const int FLUSH_INTERVAL = 16;  // Milliseconds, about one frame
+};
+
+#endif // OUTPUTPANE_H
@@ -0,0 +1,51 @@
+#ifndef PRECOMPILEDHEADER_H
+#define PRECOMPILEDHEADER_H
+
+#include <QString>
+#include <QStringList>
+#include <QDateTime>
+
+// A cached precompiled header for the leading block of system #includes of a
+// source file. The cache entry is keyed on the compiler, the build flags and the
+// include block, so changing any of them selects (and builds) a different header.
+class PrecompiledHeader
+{
+public:
+    PrecompiledHeader();
+    PrecompiledHeader(const QString &compiler, const QStringList &flags, const QString &includeBlock);
+
+    // The leading run of #include <...> lines, skipping blank lines and comments
+    static QString includeBlock(const QString &source);
+
+    bool isNull() const;
+    bool isUpToDate() const;
+    // Whether the compiler already refused this header; it is not rebuilt until pruned
+    bool hasFailed() const;
+    void markFailed() const;
+    // Keeps a header that is still in use from being pruned
+    void markUsed() const;
+
+    // Writes the header source into the cache entry
+    bool prepare(QString *errorString = nullptr) const;
+    QStringList buildArguments() const;
+    // Moves the freshly built header into place once the compiler succeeded
+    bool commit() const;
+    QStringList compileArguments() const;
+
+    static const int MAX_CACHED = 16;  // Cache entries kept before the oldest are removed
+
+private:
+    QString headerPath() const;
+    QString binaryPath() const;
+    QString failedPath() const;
+    static QString cacheRoot();
+    static QDateTime lastUsed(const QString &entry);
+    static void prune();
+
+    QString compilerProgram;
+    QStringList buildFlags;
+    QString block;
+    QString directory;
+};
+
+#endif // PRECOMPILEDHEADER_H
@@ -0,0 +1,104 @@
+#ifndef PROJECTREPLACE_H
+#define PROJECTREPLACE_H
+
+#include <QObject>
+#include <QThreadPool>
+#include <QRegularExpression>
+#include <QTextDocument>
+#include <QStringList>
+#include <QList>
+#include <atomic>
+#include <memory>
+
+struct ReplaceOptions
+{
+    QString pattern;
+    QString replacement;
+    bool regex = false;
+    bool caseSensitive = true;
+    bool wholeWord = false;
+
+    QRegularExpression expression() const;
+    // Replacement text for one match; \1..\9 refer to captures in regex mode
+    QString substitute(const QRegularExpressionMatch &match) const;
+    // Whether matching can run on the raw UTF-8 bytes
+    bool literalBytes() const { return !regex && caseSensitive && !wholeWord; }
+};
+
+struct ReplaceMatch
+{
+    int line;    // 1-based
+    int column;  // 0-based, within the line
+    int length;
+    QString lineText;
+    QString replacedLine;
+};
+
+struct FileMatches
+{
+    QString path;
+    int count = 0;
+    QList<ReplaceMatch> matches;  // The first MAX_PREVIEW_MATCHES of count
+};
+Q_DECLARE_METATYPE(FileMatches)
+
+// Finds and replaces text across a directory tree. Files are searched in batches
+// on a thread pool and reported as they match; replacing streams each file from
+// a memory map into a temporary file that atomically replaces it.
+class ProjectReplace : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ProjectReplace(QObject *parent = nullptr);
+    ~ProjectReplace();
+
+    void search(const QString &root, const ReplaceOptions &options);
+    void apply(const QStringList &paths, const ReplaceOptions &options);
+    void cancel();
+    bool isSearching() const { return searching; }
+    bool isApplying() const { return applyTotal > 0; }
+
+    // Replaces every match in an open document as one edit and returns the count
+    static int replaceInDocument(QTextDocument *document, const ReplaceOptions &options);
+
+    static const int MAX_FILE_MB = 32;            // Larger files are skipped
+    static const int BATCH_FILES = 64;            // Files searched per pool task
+    static const int MAX_PREVIEW_MATCHES = 200;   // Per file; all matches are still replaced
+    static const int MAX_PARALLEL_WRITES = 4;
+
+signals:
+    void fileMatched(const FileMatches &file);
+    void searchFinished(int files, int matches);
+    void fileReplaced(const QString &path, int count, const QString &error);
+    void applyFinished(int files, int replacements, int failures);
+
+private:
+    // Runs on the search pool, queuing a search task per batch of listed files
+    void listFiles(const QString &root, const ReplaceOptions &options,
+                   const std::shared_ptr<std::atomic_bool> &flag);
+    static QList<FileMatches> searchBatch(const QStringList &paths, const ReplaceOptions &options,
+                                          const std::atomic_bool &cancelled);
+    static bool searchFile(const QString &path, const ReplaceOptions &options,
+                           const QRegularExpression &expression, FileMatches *result);
+    static int replaceFile(const QString &path, const ReplaceOptions &options, QString *error);
+    void batchSearched(int files, const QList<FileMatches> &results);
+    void listingFinished(int files);
+    void finishSearchIfDone();
+    void fileApplied(const QString &path, int count, const QString &error);
+
+    QThreadPool *searchPool;
+    QThreadPool *writePool;
+    std::shared_ptr<std::atomic_bool> cancelled;
+    bool searching;
+    int listedFiles;   // -1 until the listing is complete
+    int searchedFiles;
+    int matchedFiles;
+    int totalMatches;
+    int applyTotal;
+    int applyDone;
+    int applyReplacements;
+    int applyFailures;
+};
+
+#endif // PROJECTREPLACE_H
@@ -0,0 +1,62 @@
+#ifndef REPLACEPANEL_H
+#define REPLACEPANEL_H
+
+#include <QWidget>
+#include <QLineEdit>
+#include <QCheckBox>
+#include <QPushButton>
+#include <QTreeWidget>
+#include <QLabel>
+#include <QPair>
+#include "projectreplace.h"
+
+// Find and replace across the project directory. Matches appear in the
+// preview as they are found; checked files are rewritten on Replace All.
+class ReplacePanel : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit ReplacePanel(QWidget *parent = nullptr);
+
+    void setRoot(const QString &directory);
+    // The file open in the editor; its matches are replaced through the editor
+    void setOpenFile(const QString &path);
+    void focusSearch(const QString &text);
+
+signals:
+    void replaceInOpenFile(const ReplaceOptions &options);
+    void matchActivated(const QString &path, int line);
+    void statusChanged(const QString &message);
+
+private slots:
+    void startSearch();
+    void replaceAll();
+    void addFile(const FileMatches &file);
+    void searchFinished(int files, int matches);
+    void fileReplaced(const QString &path, int count, const QString &error);
+    void applyFinished(int files, int replacements, int failures);
+    void itemActivated(QTreeWidgetItem *item);
+
+private:
+    ReplaceOptions currentOptions() const;
+    bool isOpenFile(const QString &path) const;
+    void setBusy(bool busy);
+
+    ProjectReplace *engine;
+    QLineEdit *findEdit;
+    QLineEdit *replaceEdit;
+    QCheckBox *regexBox;
+    QCheckBox *caseBox;
+    QCheckBox *wordBox;
+    QPushButton *findButton;
+    QPushButton *replaceButton;
+    QTreeWidget *results;
+    QLabel *summary;
+    QString root;
+    QString openFile;
+    ReplaceOptions searched;  // Options of the search shown in the preview
+    QList<QPair<QString, QString>> skipped;  // Path and error of files Replace All could not rewrite
+};
+
+#endif // REPLACEPANEL_H
@@ -0,0 +1,71 @@
+#ifndef SCOPEINDEX_H
+#define SCOPEINDEX_H
+
+#include <QObject>
+#include <QTextBlock>
+#include <QTextBlockUserData>
+#include <QTextDocument>
+#include <QVector>
+#include <QString>
+
+// Brace structure of one block, kept as the block's user data
+class ScopeBlockData : public QTextBlockUserData
+{
+public:
+    struct Bracket
+    {
+        QChar character;
+        int position;  // Within the block
+        int depth;     // Brace depth outside a '{' or '}'; 0 for other brackets
+    };
+
+    int depthBefore = 0;   // Brace depth at the start of the block
+    int depthAfter = 0;
+    int minDepth = 0;      // Lowest brace depth reached within the block
+    int openDepth = -1;    // Depth outside the outermost '{' left open by the block, or -1
+    bool commentBefore = false;
+    bool commentAfter = false;
+    bool folded = false;
+    QVector<Bracket> brackets;  // Outside comments and literals
+    QString declaration;        // The block as a file-level declaration, or empty
+    int declarationTokens = -1; // Filled in by the first reader
+};
+
+// Incremental brace and scope index of a document. An edit rescans the changed
+// blocks and then only as many following blocks as it takes for the carried
+// depth and comment state to match what they already recorded.
+class ScopeIndex : public QObject
+{
+    Q_OBJECT
+
+public:
+    // The document's index, created and filled on first use
+    static ScopeIndex *of(QTextDocument *document);
+    static ScopeBlockData *data(const QTextBlock &block);
+
+    // Position of the bracket matching the one at position, or -1
+    int matchingBracket(int position) const;
+    // Position of the '{' opening the innermost scope around position, or -1
+    int scopeStart(int position) const;
+    // Block closing the scope the block leaves open, or an invalid block
+    QTextBlock scopeEnd(const QTextBlock &block) const;
+    bool opensScope(const QTextBlock &block) const;
+
+    static const int MAX_BRACKET_SCAN_BLOCKS = 500;  // Bound for () and [] which carry no depth
+
+signals:
+    void structureChanged(int firstBlock, int lastBlock);
+
+private slots:
+    void contentsChanged(int position, int charsRemoved, int charsAdded);
+
+private:
+    explicit ScopeIndex(QTextDocument *document);
+    static void scan(const QString &text, int depth, bool inComment, ScopeBlockData *data);
+    static QString declarationOf(const QString &text);
+    void rescan(QTextBlock from, const QTextBlock &to);
+
+    QTextDocument *document;
+};
+
+#endif // SCOPEINDEX_H
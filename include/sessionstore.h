@@ -0,0 +1,40 @@
+#ifndef SESSIONSTORE_H
+#define SESSIONSTORE_H
+
+#include <QString>
+#include <QByteArray>
+#include <QVector>
+
+struct Session
+{
+    QString file;  // Empty when no saved file was open
+    int cursorPosition = 0;
+    int scrollValue = 0;
+    int firstVisibleBlock = 0;
+    int lastVisibleBlock = -1;
+};
+
+// Persists the editing session between launches, and caches the highlighter's
+// per-block states by file content so known text can be shown highlighted
+// before the rest of the document has been processed.
+class SessionStore
+{
+public:
+    static Session load();
+    static void save(const Session &session);
+
+    static QByteArray contentHash(const QString &text);
+    // The states of every block of the text with this hash, if cached for exactly expectedBlocks blocks
+    static bool loadHighlightStates(const QByteArray &hash, int expectedBlocks, QVector<int> *states);
+    static void saveHighlightStates(const QByteArray &hash, const QVector<int> &states);
+
+    static const int MAX_CACHED_STATES = 32;  // Files whose highlight states are kept
+    static const int STATES_FORMAT = 1;       // Bumped when the highlighter's states change meaning
+
+private:
+    static QString dataRoot();
+    static QString statesPath(const QByteArray &hash);
+    static void prune();
+};
+
+#endif // SESSIONSTORE_H
@@ -0,0 +1,81 @@
+#ifndef SETTINGS_H
+#define SETTINGS_H
+
+#include <QObject>
+#include <QSharedPointer>
+#include <QFileSystemWatcher>
+#include <QMutex>
+#include <QTimer>
+#include <QStringList>
+#include <QList>
+#include <QUrl>
+
+struct BuildProfile
+{
+    QString name;
+    QStringList flags;
+};
+
+// Immutable view of the configuration; safe to keep and read from any thread
+struct SettingsSnapshot
+{
+    QString apiKey;
+    QUrl endpoint;
+    QUrl alternateEndpoint;
+    QStringList models;  // The first entry is the default model
+    int tokenBudget;
+    int deadlineMs;
+    int maxAttempts;
+    bool hedging;
+    QString keepWarm;  // "never", "startup" or "always"
+    int keepWarmIdleMs;
+    int speculationBudget;  // Tokens per minute for completion prefetch, 0 disables it
+    QString telemetry;  // "off", "metrics" or "replay"
+    QString telemetryDir;  // Empty for the user data directory
+    QString compiler;
+    QList<BuildProfile> buildProfiles;
+    bool precompiledHeaders;
+    int judgeTimeLimitMs;
+    int judgeMemoryLimitMb;
+    int undoMemoryLimitMb;
+
+    BuildProfile buildProfile(const QString &name) const;
+};
+
+typedef QSharedPointer<const SettingsSnapshot> SettingsPtr;
+
+// Loads the .env configuration once and reloads it when the file changes on disk.
+class Settings : public QObject
+{
+    Q_OBJECT
+
+public:
+    static Settings *instance();
+
+    SettingsPtr snapshot() const;
+    QString path() const;
+
+signals:
+    void changed();
+
+private slots:
+    void reload();
+    void scheduleReload();
+    void directoryChanged();
+
+private:
+    explicit Settings(QObject *parent = nullptr);
+    static QByteArray readEnv(const QString &path);
+    static SettingsSnapshot parse(const QByteArray &contents);
+
+    mutable QMutex mutex;
+    SettingsPtr current;
+    QFileSystemWatcher *watcher;
+    QTimer *reloadTimer;
+    QString envPath;
+    QByteArray envContents;  // Of the loaded snapshot, to skip reloads that change nothing
+
+    static const int RELOAD_DELAY = 100;  // Milliseconds to let editors finish writing
+};
+
+#endif // SETTINGS_H
@@ -0,0 +1,15 @@
+#ifndef SOURCEFILE_H
+#define SOURCEFILE_H
+
+#include <QString>
+
+// Reads and writes source files as UTF-8 text; writes go through a temporary file
+// that atomically replaces the target.
+class SourceFile
+{
+public:
+    static bool read(const QString &fileName, QString *text, QString *errorString = nullptr);
+    static bool write(const QString &fileName, const QString &text, QString *errorString = nullptr);
+};
+
+#endif // SOURCEFILE_H
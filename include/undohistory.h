@@ -0,0 +1,82 @@
+#ifndef UNDOHISTORY_H
+#define UNDOHISTORY_H
+
+#include <QObject>
+#include <QTextEdit>
+#include <QList>
+#include <QByteArray>
+#include <QElapsedTimer>
+
+// Undo and redo for an editor, replacing the document's own unbounded stack.
+// Edits are kept as position/removed/inserted deltas, runs of keystrokes merge
+// into one step, older steps are compressed, and the oldest steps are dropped
+// once the history outgrows its memory limit.
+class UndoHistory : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit UndoHistory(QTextEdit *editor, QObject *parent = nullptr);
+
+    void setMemoryLimit(qint64 bytes);
+    qint64 memoryUsage() const { return usage; }
+    bool canUndo() const { return !undoSteps.isEmpty(); }
+    bool canRedo() const { return !redoSteps.isEmpty(); }
+
+    // Forgets all steps and resyncs with the document, e.g. after a file is loaded
+    void clear();
+
+    static const int DEFAULT_MEMORY_LIMIT_MB = 64;
+    static const int MERGE_INTERVAL_MS = 1500;  // A longer pause starts a new step
+    static const int HOT_STEPS = 32;            // Newest steps that stay uncompressed
+    static const int MIN_COMPRESS_BYTES = 256;  // Smaller steps are not worth packing
+
+public slots:
+    void undo();
+    void redo();
+
+signals:
+    void undoAvailable(bool available);
+    void redoAvailable(bool available);
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private slots:
+    void contentsChanged(int position, int charsRemoved, int charsAdded);
+
+private:
+    struct Delta
+    {
+        int position;
+        QString removed;
+        QString added;
+    };
+
+    struct Step
+    {
+        Delta delta;        // Cleared while packed
+        QByteArray packed;  // Compressed delta of a cold step
+        qint64 bytes = 0;
+    };
+
+    static qint64 sizeOf(const Delta &delta);
+    static void pack(Step *step);
+    static Delta unpack(const Step &step);
+    bool merge(const Delta &delta);
+    void push(Step step);
+    void apply(const Step &step, bool reverse);
+    void enforceLimit();
+    void emitAvailability();
+
+    QTextEdit *editor;
+    QString shadow;  // Document text before the change being recorded
+    QList<Step> undoSteps;
+    QList<Step> redoSteps;
+    QElapsedTimer lastEdit;
+    qint64 usage = 0;
+    qint64 limit = qint64(DEFAULT_MEMORY_LIMIT_MB) * 1024 * 1024;
+    bool applying = false;
+};
+
+#endif // UNDOHISTORY_H
@@ -0,0 +1,360 @@
+#include "assemblyview.h"
+#include <QtConcurrent>
+#include <QCryptographicHash>
+#include <QRegularExpression>
+#include <QTextBlock>
+#include <QTextCursor>
+#include <QScrollBar>
+#include <QFileInfo>
+#include <QDir>
+#include <QSet>
+#include <QDebug>
+#ifdef __GNUG__
+#include <cxxabi.h>
+#include <cstdlib>
+#endif
+
+static QString demangle(const QString &symbol, QHash<QString, QString> &cache)
+{
+    auto cached = cache.constFind(symbol);
+    if (cached != cache.constEnd()) return cached.value();
+
+    QString result = symbol;
+#ifdef __GNUG__
+    int status = 0;
+    char *name = abi::__cxa_demangle(symbol.toLatin1().constData(), nullptr, nullptr, &status);
+    if (status == 0 && name) {
+        result = QString::fromLatin1(name);
+    }
+    std::free(name);
+#endif
+    cache.insert(symbol, result);
+    return result;
+}
+
+static bool isDataDirective(const QString &directive)
+{
+    static const QStringList data = {
+        ".string", ".ascii", ".asciz", ".byte", ".short", ".value",
+        ".word", ".long", ".int", ".quad", ".zero", ".float", ".double"
+    };
+    for (const QString &name : data) {
+        if (directive.startsWith(name)
+            && (directive.length() == name.length() || directive.at(name.length()).isSpace())) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Debug info and exception tables only reference code; their labels are noise in the listing
+static bool isMetadataSection(const QString &name)
+{
+    return name.startsWith(".debug") || name.startsWith(".gcc_except_table") || name.startsWith(".eh_frame");
+}
+
+AssemblyListing AssemblyListing::parse(const QString &assembly, const QString &sourceFile)
+{
+    static const QRegularExpression fileDirective(R"(^\.file\s+(\d+)\s+"([^"]*)"(?:\s+"([^"]*)")?)");
+    static const QRegularExpression locDirective(R"(^\.loc\s+(\d+)\s+(\d+))");
+    static const QRegularExpression sectionDirective(R"(^\.(?:section\s+([^\s,]+)|(text|data|bss)\b))");
+    static const QRegularExpression labelDefinition(R"(^([\w.$@]+):)");
+    static const QRegularExpression labelReference(R"(\.L\w+)");
+    static const QRegularExpression mangledSymbol(R"(\b_Z[\w.$]+)");
+
+    QStringList input = assembly.split('\n');
+    QString sourceName = QFileInfo(sourceFile).fileName();
+    QString sourcePath = QDir::cleanPath(QFileInfo(sourceFile).absoluteFilePath());
+
+    // First pass: local labels that code or data outside the metadata sections refers to
+    QSet<QString> usedLabels;
+    bool inMetadata = false;
+    for (const QString &rawLine : input) {
+        QString line = rawLine.trimmed();
+        QRegularExpressionMatch section = sectionDirective.match(line);
+        if (section.hasMatch()) {
+            inMetadata = isMetadataSection(section.captured(1));
+            continue;
+        }
+        if (inMetadata || line.startsWith(".loc") || line.startsWith(".cfi")) continue;
+
+        int commentStart = line.indexOf('#');
+        if (commentStart >= 0) line.truncate(commentStart);
+        QRegularExpressionMatch label = labelDefinition.match(line);
+        if (label.hasMatch()) line = line.mid(label.capturedLength());
+
+        QRegularExpressionMatchIterator references = labelReference.globalMatch(line);
+        while (references.hasNext()) {
+            usedLabels.insert(references.next().captured(0));
+        }
+    }
+
+    // Second pass: keep instructions, named and referenced labels and their data
+    AssemblyListing listing;
+    QSet<int> sourceFileIds;
+    QHash<QString, QString> demangled;
+    int currentLine = 0;
+    bool keepData = false;
+    inMetadata = false;
+
+    for (const QString &rawLine : input) {
+        QString line = rawLine.trimmed();
+        if (line.isEmpty() || line.startsWith('#')) continue;
+
+        QRegularExpressionMatch section = sectionDirective.match(line);
+        if (section.hasMatch()) {
+            inMetadata = isMetadataSection(section.captured(1));
+            keepData = false;
+            continue;
+        }
+        if (inMetadata) continue;
+
+        QRegularExpressionMatch file = fileDirective.match(line);
+        if (file.hasMatch()) {
+            // DWARF 5 writes .file N "directory" "name"
+            QString path = file.captured(3).isEmpty() ? file.captured(2)
+                                                      : QDir(file.captured(2)).filePath(file.captured(3));
+            bool sameFile = QFileInfo(path).isAbsolute() ? QDir::cleanPath(path) == sourcePath
+                                                         : QFileInfo(path).fileName() == sourceName;
+            if (sameFile) sourceFileIds.insert(file.captured(1).toInt());
+            continue;
+        }
+
+        QRegularExpressionMatch loc = locDirective.match(line);
+        if (loc.hasMatch()) {
+            currentLine = sourceFileIds.contains(loc.captured(1).toInt()) ? loc.captured(2).toInt() : 0;
+            continue;
+        }
+
+        QRegularExpressionMatch label = labelDefinition.match(line);
+        if (label.hasMatch()) {
+            QString name = label.captured(1);
+            bool keep = !name.startsWith(".L") || usedLabels.contains(name);
+            keepData = keep;
+            if (!keep) continue;
+            listing.lines.append(demangle(name, demangled) + ":");
+            listing.sourceLines.append(0);
+            continue;
+        }
+
+        if (line.startsWith('.')) {
+            if (!keepData || !isDataDirective(line)) continue;
+        }
+
+        // Demangle every symbol on the line, keeping the verbose operand comments
+        QString text = line;
+        QRegularExpressionMatchIterator symbols = mangledSymbol.globalMatch(line);
+        int shift = 0;
+        while (symbols.hasNext()) {
+            QRegularExpressionMatch symbol = symbols.next();
+            QString name = demangle(symbol.captured(0), demangled);
+            text.replace(symbol.capturedStart() + shift, symbol.capturedLength(), name);
+            shift += name.length() - symbol.capturedLength();
+        }
+
+        int index = listing.lines.size();
+        listing.lines.append("    " + text);
+        listing.sourceLines.append(currentLine);
+        if (currentLine > 0) {
+            listing.linesForSource[currentLine].append(index);
+        }
+    }
+    return listing;
+}
+
+AssemblyView::AssemblyView(QWidget *parent)
+    : QPlainTextEdit(parent), insertedLines(0), highlightedSource(0), refreshQueued(false)
+{
+    setReadOnly(true);
+    setLineWrapMode(QPlainTextEdit::NoWrap);
+    setFont(QFont("Courier", 11));
+    document()->setUndoRedoEnabled(false);
+    setStyleSheet(
+        "QPlainTextEdit {"
+        "  background-color: #1a2634;"  // Deep ocean
+        "  color: #E2E8F0;"            // Soft white text
+        "  border: 1px solid #d2b48c;"  // Sandy border
+        "  border-radius: 4px;"
+        "  selection-background-color: #4a5d70;"  // Ocean highlight
+        "}"
+    );
+
+    process = new QProcess(this);
+    connect(process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+            this, &AssemblyView::compileFinished);
+    connect(process, &QProcess::errorOccurred, this, [this](QProcess::ProcessError error) {
+        if (error == QProcess::FailedToStart) {
+            emit statusChanged("Assembly: compiler failed to start");
+            refreshQueued = false;
+        }
+    });
+
+    parseWatcher = new QFutureWatcher<AssemblyListing>(this);
+    connect(parseWatcher, &QFutureWatcher<AssemblyListing>::finished, this, &AssemblyView::parseFinished);
+
+    sliceTimer = new QTimer(this);
+    sliceTimer->setInterval(0);
+    connect(sliceTimer, &QTimer::timeout, this, &AssemblyView::insertSlice);
+
+    connect(this, &QPlainTextEdit::cursorPositionChanged, this, &AssemblyView::selectionMoved);
+}
+
+AssemblyView::~AssemblyView()
+{
+    if (process->state() != QProcess::NotRunning) {
+        process->kill();
+        process->waitForFinished();
+    }
+    parseWatcher->waitForFinished();
+}
+
+void AssemblyView::refresh(const QString &compiler, const QStringList &flags,
+                           const QString &sourceFile, const QString &sourceText)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(compiler.toUtf8());
+    hash.addData(flags.join('\n').toUtf8());
+    hash.addData(sourceFile.toUtf8());
+    hash.addData(sourceText.toUtf8());
+
+    Request request;
+    request.key = hash.result();
+    request.compiler = compiler;
+    request.arguments = flags;
+    request.arguments << "-S" << "-g" << "-fverbose-asm" << "-o" << "-" << sourceFile;
+    request.sourceFile = sourceFile;
+
+    if (isBusy()) {
+        // Only the newest request matters; it starts when the current one is done
+        if (request.key != current.key) {
+            queued = request;
+            refreshQueued = true;
+        }
+        return;
+    }
+    if (request.key == shownKey) return;
+    startCompile(request);
+}
+
+void AssemblyView::startCompile(const Request &request)
+{
+    current = request;
+    emit statusChanged("Assembly: compiling...");
+    process->start(request.compiler, request.arguments);
+}
+
+bool AssemblyView::isBusy() const
+{
+    return process->state() != QProcess::NotRunning || parseWatcher->isRunning();
+}
+
+void AssemblyView::compileFinished(int exitCode, QProcess::ExitStatus exitStatus)
+{
+    QByteArray assembly = process->readAllStandardOutput();
+    QByteArray errors = process->readAllStandardError();
+
+    if (refreshQueued) {
+        refreshQueued = false;
+        startCompile(queued);
+        return;
+    }
+
+    if (exitCode != 0 || exitStatus != QProcess::NormalExit) {
+        sliceTimer->stop();
+        listing = AssemblyListing();
+        // The error text has no source mapping
+        insertedLines = 0;
+        highlightedSource = 0;
+        setPlainText(QString::fromLocal8Bit(errors));
+        setExtraSelections(QList<QTextEdit::ExtraSelection>());
+        shownKey = current.key;
+        emit statusChanged("Assembly: compilation failed");
+        return;
+    }
+
+    parseWatcher->setFuture(QtConcurrent::run(&AssemblyListing::parse,
+                                              QString::fromLocal8Bit(assembly), current.sourceFile));
+}
+
+void AssemblyView::parseFinished()
+{
+    if (refreshQueued) {
+        refreshQueued = false;
+        startCompile(queued);
+        return;
+    }
+
+    listing = parseWatcher->result();
+    shownKey = current.key;
+
+    // Keep the reader's place across refreshes
+    int scrollPosition = verticalScrollBar()->value();
+    insertedLines = 0;
+    clear();
+    insertSlice();
+    verticalScrollBar()->setValue(scrollPosition);
+    emit statusChanged(QString("Assembly: %1 lines").arg(listing.lines.size()));
+}
+
+void AssemblyView::insertSlice()
+{
+    int end = qMin(insertedLines + SLICE_LINES, listing.lines.size());
+    if (insertedLines < end) {
+        QTextCursor cursor(document());
+        cursor.movePosition(QTextCursor::End);
+        QString text = listing.lines.mid(insertedLines, end - insertedLines).join('\n');
+        cursor.insertText(insertedLines == 0 ? text : '\n' + text);
+        insertedLines = end;
+    }
+
+    if (insertedLines < listing.lines.size()) {
+        sliceTimer->start();
+    } else {
+        sliceTimer->stop();
+        applyHighlight(false);
+    }
+}
+
+void AssemblyView::highlightSourceLine(int line)
+{
+    if (line == highlightedSource) return;
+    highlightedSource = line;
+    applyHighlight(true);
+}
+
+void AssemblyView::applyHighlight(bool scroll)
+{
+    QList<QTextEdit::ExtraSelection> selections;
+    const QVector<int> lines = listing.linesForSource.value(highlightedSource);
+    for (int index : lines) {
+        if (index >= insertedLines || index >= listing.sourceLines.size()) break;
+        QTextEdit::ExtraSelection selection;
+        selection.format.setBackground(QColor("#4a5d70"));  // Ocean highlight
+        selection.format.setProperty(QTextFormat::FullWidthSelection, true);
+        selection.cursor = QTextCursor(document()->findBlockByNumber(index));
+        selections.append(selection);
+    }
+    setExtraSelections(selections);
+
+    if (scroll && !selections.isEmpty()) {
+        // The scroll bar of a plain text edit counts blocks
+        int first = lines.first();
+        int visible = viewport()->height() / qMax(1, fontMetrics().height());
+        QScrollBar *bar = verticalScrollBar();
+        if (first < bar->value() || first >= bar->value() + visible) {
+            bar->setValue(qMax(0, first - visible / 3));
+        }
+    }
+}
+
+void AssemblyView::selectionMoved()
+{
+    int index = textCursor().blockNumber();
+    if (index >= insertedLines || index >= listing.sourceLines.size()) return;
+    int line = listing.sourceLines.at(index);
+    if (line <= 0) return;
+
+    highlightedSource = line;
+    applyHighlight(false);
+    emit sourceLineSelected(line);
+}
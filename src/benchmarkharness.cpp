@@ -0,0 +1,247 @@
+#include "benchmarkharness.h"
+#include <QRegularExpression>
+
+// Placeholders are @NAME@ rather than %1 so the printf formats survive untouched
+static const char *harnessTemplate = R"harness(// Micro-benchmark harness generated by Beach IDE
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <type_traits>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BEACH_HAVE_TSC 1
+#endif
+
+// The benchmarked file, with its own main() out of the way
+#define main beach_user_main
+#include "@SOURCE@"
+#undef main
+
+namespace beach_bench {
+
+// Makes the compiler assume the value is read, so the work producing it is kept
+template <class T>
+inline __attribute__((always_inline)) void doNotOptimize(const T &value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+template <class T>
+inline __attribute__((always_inline)) void doNotOptimize(T &value)
+{
+#if defined(__clang__)
+    asm volatile("" : "+r,m"(value) : : "memory");
+#else
+    asm volatile("" : "+m,r"(value) : : "memory");
+#endif
+}
+
+// Makes the compiler assume all memory is read and written
+inline __attribute__((always_inline)) void clobberMemory()
+{
+    asm volatile("" : : : "memory");
+}
+
+template <class F>
+inline __attribute__((always_inline)) void invoke(F &body, std::true_type)
+{
+    body();
+    clobberMemory();
+}
+
+template <class F>
+inline __attribute__((always_inline)) void invoke(F &body, std::false_type)
+{
+    auto &&result = body();
+    doNotOptimize(result);
+    clobberMemory();
+}
+
+inline std::uint64_t nowNs()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return std::uint64_t(ts.tv_sec) * 1000000000u + std::uint64_t(ts.tv_nsec);
+}
+
+inline std::uint64_t ticks()
+{
+#ifdef BEACH_HAVE_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+} // namespace beach_bench
+
+int main()
+{
+    using namespace beach_bench;
+    const int samples = @SAMPLES@;
+    const std::uint64_t sampleNs = @SAMPLE_TARGET_US@ * 1000ull;
+    const std::uint64_t warmupNs = @WARMUP_US@ * 1000ull;
+
+@SETUP@
+    auto body = [&]() -> decltype(auto) { return (@EXPRESSION@); };
+    typedef std::is_void<decltype(body())> returnsVoid;
+
+    auto run = [&](std::uint64_t iterations) {
+        std::uint64_t start = nowNs();
+        for (std::uint64_t i = 0; i < iterations; ++i) {
+            invoke(body, returnsVoid());
+        }
+        return nowNs() - start;
+    };
+
+    // Warm caches, branch predictors and the CPU clock before measuring
+    std::uint64_t iterations = 1;
+    for (std::uint64_t warmupEnd = nowNs() + warmupNs; nowNs() < warmupEnd;) {
+        run(iterations);
+        if (iterations < (1u << 20)) iterations *= 2;
+    }
+
+    // Grow the iteration count until one sample dwarfs the timer overhead
+    iterations = 1;
+    for (;;) {
+        std::uint64_t elapsed = run(iterations);
+        if (elapsed >= sampleNs) break;
+        double scale = elapsed > 0 ? 1.2 * double(sampleNs) / double(elapsed) : 10.0;
+        scale = std::min(10.0, std::max(1.5, scale));
+        iterations = std::uint64_t(double(iterations) * scale) + 1;
+    }
+
+    std::vector<double> nsPerOp;
+    double cyclesPerOp = 0;
+    for (int sample = 0; sample < samples; ++sample) {
+        std::uint64_t startTicks = ticks();
+        std::uint64_t elapsed = run(iterations);
+        cyclesPerOp += double(ticks() - startTicks) / double(iterations);
+        nsPerOp.push_back(double(elapsed) / double(iterations));
+    }
+    cyclesPerOp /= samples;
+
+    double mean = 0;
+    for (double value : nsPerOp) mean += value;
+    mean /= samples;
+    double variance = 0;
+    for (double value : nsPerOp) variance += (value - mean) * (value - mean);
+    variance /= samples - 1;
+    // Student's t for a 95% interval with samples - 1 = 29 degrees of freedom
+    double halfWidth = 2.045 * std::sqrt(variance / samples);
+    std::sort(nsPerOp.begin(), nsPerOp.end());
+
+    std::printf("Benchmark: %s\n", "@LABEL@");
+    std::printf("  %d samples x %llu iterations\n", samples, (unsigned long long)iterations);
+    std::printf("  %.3f ns/op  (95%% CI %.3f .. %.3f, +/-%.1f%%)\n",
+                mean, mean - halfWidth, mean + halfWidth, mean > 0 ? 100.0 * halfWidth / mean : 0.0);
+    std::printf("  median %.3f ns/op, min %.3f ns/op\n", nsPerOp[samples / 2], nsPerOp.front());
+#ifdef BEACH_HAVE_TSC
+    std::printf("  %.1f TSC cycles/op\n", cyclesPerOp);
+#endif
+    return 0;
+}
+)harness";
+
+static QString stripComments(const QString &text)
+{
+    static const QRegularExpression lineComment("//[^\n]*");
+    static const QRegularExpression blockComment(R"(/\*.*?\*/)", QRegularExpression::DotMatchesEverythingOption);
+    QString result = text;
+    result.remove(blockComment);
+    result.remove(lineComment);
+    return result;
+}
+
+QString BenchmarkHarness::functionName(const QString &selection, bool *hasParameters)
+{
+    static const QRegularExpression definition(
+        R"(([A-Za-z_]\w*)\s*\(([^()]*)\)\s*(?:const\s*)?(?:noexcept\s*)?(?:->\s*[^{;]+)?\{)");
+    static const QStringList keywords = {"if", "for", "while", "switch", "catch", "return", "sizeof"};
+
+    QString text = stripComments(selection).trimmed();
+    if (!text.endsWith('}')) return QString();
+
+    QRegularExpressionMatch match = definition.match(text);
+    if (!match.hasMatch() || keywords.contains(match.captured(1))) return QString();
+
+    // Only a definition if nothing but its return type and template header precede the name
+    QString head = text.left(match.capturedStart()).trimmed();
+    if (head.contains(';') || head.contains('{') || head.contains('=')) return QString();
+
+    if (hasParameters) {
+        QString parameters = match.captured(2).trimmed();
+        *hasParameters = !parameters.isEmpty() && parameters != "void";
+    }
+    return match.captured(1);
+}
+
+void BenchmarkHarness::splitSnippet(const QString &snippet, QString *setup, QString *expression)
+{
+    QString text = stripComments(snippet).trimmed();
+    while (text.endsWith(';')) {
+        text.chop(1);
+        text = text.trimmed();
+    }
+
+    int depth = 0;
+    int split = -1;
+    bool inString = false;
+    QChar quote;
+    for (int i = 0; i < text.length(); ++i) {
+        QChar c = text.at(i);
+        if (inString) {
+            if (c == '\\') ++i;
+            else if (c == quote) inString = false;
+            continue;
+        }
+        if (c == '"' || c == '\'') {
+            inString = true;
+            quote = c;
+        } else if (c == '(' || c == '[' || c == '{') {
+            ++depth;
+        } else if (c == ')' || c == ']' || c == '}') {
+            --depth;
+        } else if (c == ';' && depth == 0) {
+            split = i;
+        }
+    }
+
+    *setup = split < 0 ? QString() : text.left(split + 1).trimmed();
+    *expression = split < 0 ? text : text.mid(split + 1).trimmed();
+}
+
+QString BenchmarkHarness::generate(const QString &sourceFile, const QString &setup, const QString &expression)
+{
+    QString label = expression.simplified();
+    label.replace('\\', "\\\\").replace('"', "\\\"");
+    QString includePath = sourceFile;
+    includePath.replace('\\', "/");
+
+    QStringList setupLines;
+    for (const QString &line : setup.split('\n')) {
+        if (!line.trimmed().isEmpty()) setupLines.append("    " + line.trimmed());
+    }
+
+    QString harness = QString::fromUtf8(harnessTemplate);
+    harness.replace("@SOURCE@", includePath);
+    harness.replace("@SAMPLES@", QString::number(SAMPLES));
+    harness.replace("@SAMPLE_TARGET_US@", QString::number(SAMPLE_TARGET_US));
+    harness.replace("@WARMUP_US@", QString::number(WARMUP_US));
+    harness.replace("@SETUP@", setupLines.join('\n'));
+    harness.replace("@EXPRESSION@", expression);
+    harness.replace("@LABEL@", label);
+    return harness;
+}
+
+bool BenchmarkHarness::optimizes(const QStringList &flags)
+{
+    bool optimized = false;
+    for (const QString &flag : flags) {
+        if (flag.startsWith("-O")) optimized = flag != "-O0";
+    }
+    return optimized;
+}
@@ -0,0 +1,163 @@
+#include "codefolding.h"
+#include <QTextDocument>
+#include <QTextCursor>
+
+CodeFolding::CodeFolding(QTextEdit *editor, QObject *parent)
+    : QObject(parent), editor(editor)
+{
+    // The index connects first, so it is up to date when contentsChanged runs
+    index = ScopeIndex::of(editor->document());
+    connect(editor->document(), &QTextDocument::contentsChange, this, &CodeFolding::contentsChanged);
+}
+
+QList<QTextEdit::ExtraSelection> CodeFolding::selections() const
+{
+    QList<QTextEdit::ExtraSelection> marks;
+    for (QTextBlock block = editor->document()->begin(); block.isValid(); block = block.next()) {
+        ScopeBlockData *data = ScopeIndex::data(block);
+        if (!data || !data->folded || !block.isVisible()) continue;
+
+        QTextEdit::ExtraSelection mark;
+        mark.format.setBackground(QColor("#3d4d5e"));  // Slate, like the ocean floor
+        mark.format.setProperty(QTextFormat::FullWidthSelection, true);
+        mark.cursor = QTextCursor(block);
+        marks.append(mark);
+    }
+    return marks;
+}
+
+void CodeFolding::toggleFoldAtCursor()
+{
+    QTextCursor cursor = editor->textCursor();
+    QTextBlock block = cursor.block();
+    ScopeBlockData *data = ScopeIndex::data(block);
+    if (data && data->folded) {
+        unfold(block);
+        return;
+    }
+    if (index->opensScope(block) && fold(block)) return;
+
+    // Otherwise fold the scope the cursor is in and keep the cursor on a visible line
+    int open = index->scopeStart(cursor.position());
+    if (open < 0) return;
+    if (fold(editor->document()->findBlock(open))) {
+        cursor.setPosition(open);
+        editor->setTextCursor(cursor);
+    }
+}
+
+void CodeFolding::foldAll()
+{
+    QTextDocument *doc = editor->document();
+    for (QTextBlock block = doc->begin(); block.isValid(); block = block.next()) {
+        ScopeBlockData *data = ScopeIndex::data(block);
+        if (!data || data->folded || data->openDepth < 0) continue;
+        QTextBlock end = index->scopeEnd(block);
+        if (!end.isValid() || end == block.next()) continue;
+
+        // Inner scopes fold too, so they stay folded when their parent opens
+        data->folded = true;
+        for (QTextBlock hidden = block.next(); hidden != end; hidden = hidden.next()) {
+            hidden.setVisible(false);
+        }
+    }
+
+    QTextCursor cursor = editor->textCursor();
+    QTextBlock visible = cursor.block();
+    while (visible.isValid() && !visible.isVisible()) {
+        visible = visible.previous();
+    }
+    if (visible != cursor.block() && visible.isValid()) {
+        cursor.setPosition(visible.position());
+        editor->setTextCursor(cursor);
+    }
+    relayout(doc->begin(), doc->lastBlock());
+}
+
+void CodeFolding::unfoldAll()
+{
+    QTextDocument *doc = editor->document();
+    for (QTextBlock block = doc->begin(); block.isValid(); block = block.next()) {
+        ScopeBlockData *data = ScopeIndex::data(block);
+        if (data) data->folded = false;
+        block.setVisible(true);
+    }
+    relayout(doc->begin(), doc->lastBlock());
+}
+
+bool CodeFolding::fold(const QTextBlock &start)
+{
+    ScopeBlockData *data = ScopeIndex::data(start);
+    QTextBlock end = index->scopeEnd(start);
+    if (!data || !end.isValid() || end == start.next()) return false;
+
+    data->folded = true;
+    for (QTextBlock block = start.next(); block != end; block = block.next()) {
+        block.setVisible(false);
+    }
+    relayout(start, end);
+    return true;
+}
+
+void CodeFolding::unfold(const QTextBlock &start)
+{
+    ScopeBlockData *data = ScopeIndex::data(start);
+    if (data) data->folded = false;
+
+    // Reveal the hidden run after the start, leaving folded inner scopes collapsed
+    QTextBlock block = start.next();
+    while (block.isValid() && !block.isVisible()) {
+        block.setVisible(true);
+        ScopeBlockData *blockData = ScopeIndex::data(block);
+        if (blockData && blockData->folded) {
+            QTextBlock innerEnd = index->scopeEnd(block);
+            if (innerEnd.isValid()) {
+                block = innerEnd;
+                continue;
+            }
+            blockData->folded = false;
+        }
+        block = block.next();
+    }
+    relayout(start, block.isValid() ? block : editor->document()->lastBlock());
+}
+
+void CodeFolding::relayout(const QTextBlock &from, const QTextBlock &to)
+{
+    QTextDocument *doc = editor->document();
+    int end = to.isValid() ? to.position() + to.length() : doc->characterCount();
+    doc->markContentsDirty(from.position(), qMax(0, qMin(end, doc->characterCount()) - from.position()));
+    editor->viewport()->update();
+    emit foldsChanged();
+}
+
+void CodeFolding::contentsChanged(int position, int charsRemoved, int charsAdded)
+{
+    Q_UNUSED(charsRemoved);
+    QTextDocument *doc = editor->document();
+    QTextBlock block = doc->findBlock(position);
+    QTextBlock last = doc->findBlock(position + charsAdded);
+    if (!last.isValid()) last = doc->lastBlock();
+
+    for (; block.isValid(); block = block.next()) {
+        if (!block.isVisible()) {
+            // Text changed inside a fold: open it so the edit is not invisible
+            QTextBlock start = block;
+            while (start.isValid() && !start.isVisible()) {
+                start = start.previous();
+            }
+            if (start.isValid()) unfold(start);
+        } else {
+            // A folded line whose scope now ends elsewhere no longer matches what is hidden
+            ScopeBlockData *data = ScopeIndex::data(block);
+            if (data && data->folded) {
+                QTextBlock nextVisible = block.next();
+                while (nextVisible.isValid() && !nextVisible.isVisible()) {
+                    nextVisible = nextVisible.next();
+                }
+                if (index->scopeEnd(block) != nextVisible) unfold(block);
+            }
+        }
+        if (block == last) break;
+    }
+}
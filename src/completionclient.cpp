@@ -0,0 +1,434 @@
+#include "completionclient.h"
+#include <QNetworkRequest>
+#include <QJsonDocument>
+#include <QRandomGenerator>
+#include <QDebug>
+#include <algorithm>
+
+const QString CompletionClient::DEFAULT_ENDPOINT = "https://api.openai.com/v1/chat/completions";
+
+CompletionClient::CompletionClient(QObject *parent)
+    : QObject(parent), endpointUrl(DEFAULT_ENDPOINT), policy(WarmOnStartup), nextId(1),
+      deadlineMs(DEFAULT_DEADLINE_MS), maxAttempts(DEFAULT_MAX_ATTEMPTS), hedgingEnabled(false),
+      nextSample(0), circuit(CircuitClosed), consecutiveFailures(0),
+      failureThreshold(DEFAULT_FAILURE_THRESHOLD), cooldownMs(DEFAULT_COOLDOWN_MS), probeInFlight(false),
+      requestedSinceWarm(true)
+{
+    qRegisterMetaType<RequestTiming>();
+
+    networkManager = new QNetworkAccessManager(this);
+    connect(networkManager, &QNetworkAccessManager::finished,
+            this, &CompletionClient::handleFinished);
+    connect(networkManager, &QNetworkAccessManager::encrypted,
+            this, &CompletionClient::handleEncrypted);
+
+    // Offer HTTP/2 during the TLS handshake so requests multiplex over one session
+    sslConfig = QSslConfiguration::defaultConfiguration();
+    sslConfig.setAllowedNextProtocols({QSslConfiguration::ALPNProtocolHTTP2,
+                                       QSslConfiguration::NextProtocolHttp1_1});
+
+    idleTimer = new QTimer(this);
+    idleTimer->setSingleShot(true);
+    idleTimer->setInterval(DEFAULT_IDLE_MS);
+    connect(idleTimer, &QTimer::timeout, this, &CompletionClient::prewarm);
+
+    // Deferred so the endpoint and policy can be configured right after construction
+    QTimer::singleShot(0, this, &CompletionClient::prewarm);
+}
+
+void CompletionClient::setEndpoint(const QUrl &url)
+{
+    if (endpointUrl == url) return;
+    endpointUrl = url;
+    prewarm();
+}
+
+QUrl CompletionClient::endpoint() const
+{
+    return endpointUrl;
+}
+
+void CompletionClient::setAlternateEndpoint(const QUrl &url)
+{
+    if (alternateUrl == url) return;
+    alternateUrl = url;
+    prewarm();
+}
+
+QUrl CompletionClient::alternateEndpoint() const
+{
+    return alternateUrl;
+}
+
+void CompletionClient::setApiKey(const QString &key)
+{
+    apiKey = key;
+}
+
+void CompletionClient::setKeepWarmPolicy(KeepWarmPolicy newPolicy, int idleMs)
+{
+    policy = newPolicy;
+    idleTimer->setInterval(idleMs);
+    if (policy != KeepWarm) {
+        idleTimer->stop();
+    }
+}
+
+CompletionClient::KeepWarmPolicy CompletionClient::keepWarmPolicy() const
+{
+    return policy;
+}
+
+void CompletionClient::setSslConfiguration(const QSslConfiguration &config)
+{
+    sslConfig = config;
+}
+
+void CompletionClient::setDeadline(int ms)
+{
+    deadlineMs = qMax(1, ms);
+}
+
+void CompletionClient::setMaxAttempts(int count)
+{
+    maxAttempts = qMax(1, count);
+}
+
+void CompletionClient::setHedgingEnabled(bool enabled)
+{
+    hedgingEnabled = enabled;
+}
+
+void CompletionClient::setCircuitBreaker(int threshold, int cooldown)
+{
+    failureThreshold = qMax(1, threshold);
+    cooldownMs = qMax(0, cooldown);
+}
+
+CompletionClient::CircuitState CompletionClient::circuitState() const
+{
+    return circuit;
+}
+
+void CompletionClient::connectTo(const QUrl &url)
+{
+    if (!url.isValid()) return;
+    qDebug() << "Pre-connecting to" << url.host();
+    if (url.scheme() == "https") {
+        networkManager->connectToHostEncrypted(url.host(), url.port(443), sslConfig);
+    } else {
+        networkManager->connectToHost(url.host(), url.port(80));
+    }
+}
+
+void CompletionClient::prewarm()
+{
+    if (policy == NoKeepWarm) return;
+
+    // Resolve DNS and finish the TCP/TLS handshake before the first request needs it
+    connectTo(endpointUrl);
+    if (hedgingEnabled) {
+        connectTo(alternateUrl);
+    }
+
+    // Re-arm only while the endpoint is in use; an idle period with no requests
+    // gets this one last warm-up and the next request starts the cycle again
+    if (policy == KeepWarm && requestedSinceWarm) {
+        idleTimer->start();
+    }
+    requestedSinceWarm = false;
+}
+
+quint64 CompletionClient::send(const QJsonObject &body, Priority priority)
+{
+    // Speculation never probes a recovering endpoint or spends a request on a failing one
+    if (priority == Speculative && circuit != CircuitClosed) return 0;
+
+    quint64 id = nextId++;
+    idleTimer->stop();
+    requestedSinceWarm = true;
+
+    if (!allowRequest()) {
+        // Fail fast while the circuit is open, reported asynchronously like any other failure
+        QTimer::singleShot(0, this, [this, id]() {
+            emit requestFailed(id, 0, "Circuit open", RequestTiming());
+        });
+        return id;
+    }
+
+    PendingRequest &request = requests[id];
+    request.body = body;
+    request.speculative = priority == Speculative;
+    request.started.start();
+    if (circuit == CircuitHalfOpen) {
+        request.probe = true;
+        probeInFlight = true;
+    }
+    startAttempt(id, false);
+
+    QTimer::singleShot(deadlineMs, this, [this, id]() {
+        auto it = requests.find(id);
+        if (it == requests.end()) return;
+        RequestTiming timing;
+        timing.totalMs = it->started.elapsed();
+        timing.attempts = it->attempts;
+        qDebug() << "Completion request" << id << "missed its deadline";
+        if (!it->speculative) {
+            recordOutcome(false);
+        }
+        fail(id, 0, "Deadline exceeded", timing);
+    });
+    return id;
+}
+
+void CompletionClient::startAttempt(quint64 id, bool hedge)
+{
+    PendingRequest &request = requests[id];
+    QNetworkRequest networkRequest(hedge ? alternateUrl : endpointUrl);
+    networkRequest.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+    networkRequest.setRawHeader("Authorization", QString("Bearer %1").arg(apiKey).toUtf8());
+    networkRequest.setAttribute(QNetworkRequest::Http2AllowedAttribute, true);
+    if (request.speculative) {
+        networkRequest.setPriority(QNetworkRequest::LowPriority);
+    }
+    if (networkRequest.url().scheme() == "https") {
+        networkRequest.setSslConfiguration(sslConfig);
+    }
+
+    if (!hedge) {
+        ++request.attempts;
+    }
+
+    Attempt attempt;
+    attempt.id = id;
+    attempt.timer.start();
+    attempt.hedge = hedge;
+
+    QNetworkReply *reply = networkManager->post(networkRequest,
+                                                QJsonDocument(request.body).toJson(QJsonDocument::Compact));
+    attempts.insert(reply, attempt);
+    request.replies.append(reply);
+
+    // Without TLS there is no handshake signal; the body starting to go out marks
+    // the connection as ready, which includes the TCP setup when one was opened
+    if (networkRequest.url().scheme() != "https") {
+        connect(reply, &QNetworkReply::uploadProgress, this, [this, reply](qint64 bytesSent) {
+            auto it = attempts.find(reply);
+            if (bytesSent > 0 && it != attempts.end() && it->timing.connectMs < 0) {
+                it->timing.connectMs = it->timer.elapsed();
+            }
+        });
+    }
+
+    // Response headers arriving marks the time to first byte
+    connect(reply, &QNetworkReply::metaDataChanged, this, [this, reply]() {
+        auto it = attempts.find(reply);
+        if (it != attempts.end() && it->timing.ttfbMs < 0) {
+            it->timing.ttfbMs = it->timer.elapsed();
+        }
+    });
+
+    // If the primary runs past its usual p95 latency, race it against the alternate endpoint
+    if (!hedge && hedgingEnabled && alternateUrl.isValid() && !request.hedged && !request.speculative) {
+        QTimer::singleShot(hedgeThreshold(), this, [this, id]() {
+            auto it = requests.find(id);
+            if (it == requests.end() || it->hedged || it->replies.isEmpty()) return;
+            it->hedged = true;
+            qDebug() << "Hedging completion request" << id << "to" << alternateUrl.host();
+            startAttempt(id, true);
+        });
+    }
+}
+
+void CompletionClient::handleEncrypted(QNetworkReply *reply)
+{
+    // Only emitted when a request had to open a new connection
+    auto it = attempts.find(reply);
+    if (it != attempts.end()) {
+        it->timing.connectMs = it->timer.elapsed();
+    }
+}
+
+void CompletionClient::handleFinished(QNetworkReply *reply)
+{
+    reply->deleteLater();
+    auto it = attempts.find(reply);
+    if (it == attempts.end()) return;  // Pre-connect probes finish here too
+
+    Attempt attempt = it.value();
+    attempts.erase(it);
+
+    auto requestIt = requests.find(attempt.id);
+    if (requestIt == requests.end()) return;  // Lost a hedge race or was cut off by the deadline
+    requestIt->replies.removeOne(reply);
+
+    RequestTiming timing = attempt.timing;
+    timing.totalMs = requestIt->started.elapsed();
+    timing.http2 = reply->attribute(QNetworkRequest::HTTP2WasUsedAttribute).toBool();
+    timing.attempts = requestIt->attempts;
+    timing.hedged = attempt.hedge;
+    qDebug() << "Completion request" << attempt.id << "connect:" << timing.connectMs
+             << "ms, TTFB:" << timing.ttfbMs << "ms, total:" << timing.totalMs
+             << "ms, HTTP/2:" << timing.http2 << "attempts:" << timing.attempts
+             << "hedged:" << timing.hedged;
+
+    QByteArray response = reply->readAll();
+    int statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    // Speculative outcomes stay out of the latency and failure statistics
+    const bool counted = !attempt.hedge && !requestIt->speculative;
+    if (reply->error() == QNetworkReply::NoError) {
+        if (counted) {
+            if (latencySamples.size() < LATENCY_SAMPLES) {
+                latencySamples.append(attempt.timer.elapsed());
+            } else {
+                latencySamples[nextSample] = attempt.timer.elapsed();
+                nextSample = (nextSample + 1) % LATENCY_SAMPLES;
+            }
+            recordOutcome(true);
+        }
+        complete(attempt.id, QJsonDocument::fromJson(response).object(), timing);
+        return;
+    }
+
+    qDebug() << "Network error:" << statusCode << reply->errorString();
+    qDebug() << "Error details:" << response;
+    if (counted && isRetryable(reply)) {
+        recordOutcome(false);
+    }
+    if (!requestIt->replies.isEmpty()) return;  // The other side of a hedge is still running
+
+    bool ok = false;
+    int retryAfterMs = reply->rawHeader("Retry-After").toInt(&ok) * 1000;
+    if (isRetryable(reply) && !requestIt->speculative && requestIt->attempts < maxAttempts && circuit != CircuitOpen
+        && scheduleRetry(attempt.id, ok ? retryAfterMs : 0)) {
+        return;
+    }
+    fail(attempt.id, statusCode, reply->errorString(), timing);
+}
+
+bool CompletionClient::scheduleRetry(quint64 id, int retryAfterMs)
+{
+    const PendingRequest &request = requests[id];
+
+    // Exponential backoff with equal jitter so concurrent clients spread their retries
+    int backoff = qMin(int(MAX_BACKOFF_MS), BASE_BACKOFF_MS << (request.attempts - 1));
+    int delay = backoff / 2 + QRandomGenerator::global()->bounded(backoff / 2 + 1);
+    delay = qMax(delay, retryAfterMs);
+    if (request.started.elapsed() + delay >= deadlineMs) return false;
+
+    qDebug() << "Retrying completion request" << id << "in" << delay << "ms";
+    QTimer::singleShot(delay, this, [this, id]() {
+        if (requests.contains(id)) {
+            startAttempt(id, false);
+        }
+    });
+    return true;
+}
+
+void CompletionClient::complete(quint64 id, const QJsonObject &response, const RequestTiming &timing)
+{
+    PendingRequest request = requests.take(id);
+    if (request.probe) {
+        probeInFlight = false;
+    }
+    // Cancel the losing side of a hedge; its finished() is ignored
+    for (QNetworkReply *other : qAsConst(request.replies)) {
+        other->abort();
+    }
+    if (policy == KeepWarm && requests.isEmpty()) {
+        idleTimer->start();
+    }
+    emit replyReceived(id, response, timing);
+}
+
+void CompletionClient::fail(quint64 id, int statusCode, const QString &error, const RequestTiming &timing)
+{
+    PendingRequest request = requests.take(id);
+    if (request.probe) {
+        probeInFlight = false;
+    }
+    for (QNetworkReply *other : qAsConst(request.replies)) {
+        other->abort();
+    }
+    if (policy == KeepWarm && requests.isEmpty()) {
+        idleTimer->start();
+    }
+    emit requestFailed(id, statusCode, error, timing);
+}
+
+void CompletionClient::recordOutcome(bool success)
+{
+    if (success) {
+        consecutiveFailures = 0;
+        setCircuitState(CircuitClosed);
+        return;
+    }
+
+    ++consecutiveFailures;
+    if (circuit == CircuitHalfOpen || consecutiveFailures >= failureThreshold) {
+        circuitOpened.start();
+        setCircuitState(CircuitOpen);
+    }
+}
+
+void CompletionClient::setCircuitState(CircuitState state)
+{
+    if (circuit == state) return;
+    circuit = state;
+    qDebug() << "Completion circuit breaker state:" << state;
+    emit circuitStateChanged(state);
+}
+
+bool CompletionClient::allowRequest()
+{
+    if (circuit == CircuitOpen) {
+        if (circuitOpened.elapsed() < cooldownMs) return false;
+        setCircuitState(CircuitHalfOpen);
+    }
+    if (circuit == CircuitHalfOpen) {
+        return !probeInFlight;
+    }
+    return true;
+}
+
+int CompletionClient::hedgeThreshold() const
+{
+    if (latencySamples.size() < MIN_HEDGE_SAMPLES) return DEFAULT_HEDGE_MS;
+
+    QVector<qint64> sorted = latencySamples;
+    auto p95 = sorted.begin() + (sorted.size() * 95) / 100;
+    std::nth_element(sorted.begin(), p95, sorted.end());
+    return int(*p95);
+}
+
+bool CompletionClient::isRetryable(QNetworkReply *reply)
+{
+    int statusCode = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    switch (statusCode) {
+        case 408:
+        case 425:
+        case 429:
+        case 500:
+        case 502:
+        case 503:
+        case 504:
+            return true;
+        case 0:
+            break;
+        default:
+            return false;
+    }
+
+    // No HTTP status: only transport failures that may succeed on a new attempt
+    switch (reply->error()) {
+        case QNetworkReply::ConnectionRefusedError:
+        case QNetworkReply::RemoteHostClosedError:
+        case QNetworkReply::TimeoutError:
+        case QNetworkReply::TemporaryNetworkFailureError:
+        case QNetworkReply::NetworkSessionFailedError:
+        case QNetworkReply::UnknownNetworkError:
+            return true;
+        default:
+            return false;
+    }
+}
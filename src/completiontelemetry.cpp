@@ -0,0 +1,175 @@
+#include "completiontelemetry.h"
+#include <QStandardPaths>
+#include <QRandomGenerator>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QDebug>
+
+static QByteArray packText(const QString &text)
+{
+    return text.isEmpty() ? QByteArray() : qCompress(text.toUtf8());
+}
+
+static QString unpackText(const QByteArray &data)
+{
+    return data.isEmpty() ? QString() : QString::fromUtf8(qUncompress(data));
+}
+
+static QByteArray serialize(const CompletionEvent &event)
+{
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    out << event.session << event.elapsedMs << event.timestamp << event.contextHash << event.backend
+        << event.source << event.trigger << event.speculative
+        << event.queueMs << event.connectMs << event.ttfbMs << event.totalMs << event.attempts
+        << event.promptTokens << event.completionTokens << event.statusCode
+        << event.outcome << event.candidates << event.acceptedIndex
+        << packText(event.prefix) << packText(event.suffix);
+    return data;
+}
+
+static bool deserialize(const QByteArray &data, CompletionEvent *event)
+{
+    QByteArray prefix;
+    QByteArray suffix;
+    QDataStream in(data);
+    in >> event->session >> event->elapsedMs >> event->timestamp >> event->contextHash >> event->backend
+       >> event->source >> event->trigger >> event->speculative
+       >> event->queueMs >> event->connectMs >> event->ttfbMs >> event->totalMs >> event->attempts
+       >> event->promptTokens >> event->completionTokens >> event->statusCode
+       >> event->outcome >> event->candidates >> event->acceptedIndex
+       >> prefix >> suffix;
+    if (in.status() != QDataStream::Ok) return false;
+    event->prefix = unpackText(prefix);
+    event->suffix = unpackText(suffix);
+    return true;
+}
+
+CompletionTelemetry::CompletionTelemetry(QObject *parent)
+    : QObject(parent), logMode(Metrics), logDirectory(defaultDirectory()),
+      session(QRandomGenerator::global()->generate64())
+{
+    sessionTimer.start();
+}
+
+QString CompletionTelemetry::defaultDirectory()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) + "/beach-ide/telemetry";
+}
+
+void CompletionTelemetry::setMode(Mode mode)
+{
+    logMode = mode;
+    if (logMode == Off) log.close();
+}
+
+CompletionTelemetry::Mode CompletionTelemetry::mode() const
+{
+    return logMode;
+}
+
+void CompletionTelemetry::setDirectory(const QString &directory)
+{
+    const QString resolved = directory.isEmpty() ? defaultDirectory() : directory;
+    if (resolved == logDirectory) return;
+    log.close();
+    logDirectory = resolved;
+}
+
+QString CompletionTelemetry::directory() const
+{
+    return logDirectory;
+}
+
+void CompletionTelemetry::start(CompletionEvent *event) const
+{
+    event->session = session;
+    event->elapsedMs = sessionTimer.elapsed();
+    event->timestamp = QDateTime::currentMSecsSinceEpoch();
+}
+
+QString CompletionTelemetry::logPath(int index) const
+{
+    QString path = logDirectory + "/completions.log";
+    return index == 0 ? path : path + '.' + QString::number(index);
+}
+
+bool CompletionTelemetry::openLog()
+{
+    if (log.isOpen()) return true;
+
+    QDir().mkpath(logDirectory);
+    log.setFileName(logPath(0));
+    if (!log.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        qDebug() << "Cannot open completion telemetry log:" << log.errorString();
+        return false;
+    }
+    if (log.size() == 0) {
+        QDataStream out(&log);
+        out << LOG_MAGIC << LOG_VERSION;
+    }
+    return true;
+}
+
+void CompletionTelemetry::rotate()
+{
+    log.close();
+    QFile::remove(logPath(MAX_LOG_FILES - 1));
+    for (int i = MAX_LOG_FILES - 2; i >= 0; --i) {
+        QFile::rename(logPath(i), logPath(i + 1));
+    }
+}
+
+void CompletionTelemetry::record(const CompletionEvent &event)
+{
+    if (logMode == Off) return;
+
+    CompletionEvent stored = event;
+    if (logMode != Replay) {
+        stored.prefix.clear();
+        stored.suffix.clear();
+    }
+    QByteArray payload = serialize(stored);
+
+    if (!openLog()) return;
+    if (log.size() + payload.size() > MAX_LOG_BYTES) {
+        rotate();
+        if (!openLog()) return;
+    }
+    // Each record is length-prefixed, so a record cut short by a crash ends the log cleanly
+    QDataStream out(&log);
+    out << payload;
+    log.flush();
+}
+
+bool CompletionTelemetry::readLog(const QString &path, QVector<CompletionEvent> *events)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) return false;
+
+    QDataStream in(&file);
+    quint32 magic = 0;
+    quint16 version = 0;
+    in >> magic >> version;
+    if (magic != LOG_MAGIC || version != LOG_VERSION) return false;
+
+    while (!in.atEnd()) {
+        QByteArray payload;
+        in >> payload;
+        CompletionEvent event;
+        if (in.status() != QDataStream::Ok || !deserialize(payload, &event)) break;
+        events->append(event);
+    }
+    return true;
+}
+
+QVector<CompletionEvent> CompletionTelemetry::readDirectory(const QString &directory)
+{
+    QVector<CompletionEvent> events;
+    const QString base = directory + "/completions.log";
+    for (int i = MAX_LOG_FILES - 1; i >= 0; --i) {
+        readLog(i == 0 ? base : base + '.' + QString::number(i), &events);
+    }
+    return events;
+}
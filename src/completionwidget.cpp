@@ -1,33 +1,59 @@
 #include "completionwidget.h"
+#include "settings.h"
 #include <QPainter>
 #include <QTextBlock>
 #include <QKeyEvent>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
-#include <QFile>
-#include <QTextStream>
-#include <QDir>
-
-const QString CompletionWidget::DEFAULT_MODEL = "gpt-4";
-const QStringList CompletionWidget::AVAILABLE_MODELS = {"gpt-4", "gpt-3.5-turbo"};
+#include <QVector>
+#include <QHash>
+#include <QRegularExpression>
+#include <QCryptographicHash>
+#include <algorithm>
+#include <numeric>
 
 CompletionWidget::CompletionWidget(QTextEdit *parent)
-    : QFrame(parent), editor(parent), model(DEFAULT_MODEL)
+    : QFrame(parent), editor(parent), candidateIndex(0), cache(CACHE_ENTRIES),
+      speculationBudget(DEFAULT_SPECULATION_BUDGET), budgetTokens(DEFAULT_SPECULATION_BUDGET),
+      speculations(0), cacheHits(0), latestInteractive(0), showingEvent(false)
 {
     setFrameStyle(QFrame::Box | QFrame::Plain);
     setLineWidth(1);
     
-    // Set up network manager
-    networkManager = new QNetworkAccessManager(this);
-    connect(networkManager, &QNetworkAccessManager::finished,
-            this, &CompletionWidget::handleNetworkReply);
+    // Set up completion client; it pre-connects to the endpoint in the background
+    client = new CompletionClient(this);
+    connect(client, &CompletionClient::replyReceived,
+            this, &CompletionWidget::handleCompletionReply);
+    connect(client, &CompletionClient::requestFailed,
+            this, &CompletionWidget::handleCompletionFailure);
+
+    // Set up prompt context packing
+    contextBuilder = new ContextBuilder(editor, this);
+
+    // Local record of each completion's latency and outcome
+    telemetry = new CompletionTelemetry(this);
+    triggered.start();
+
+    // Apply configuration now and whenever the .env file changes
+    applySettings();
+    connect(Settings::instance(), &Settings::changed,
+            this, &CompletionWidget::applySettings);
 
     // Set up completion timer
     completionTimer = new QTimer(this);
     completionTimer->setSingleShot(true);
-    connect(completionTimer, &QTimer::timeout,
-            this, &CompletionWidget::requestCompletion);
+    connect(completionTimer, &QTimer::timeout, this, [this]() {
+        triggerCompletion(CompletionEvent::TypingPause);
+    });
+
+    // Prefetch the next line's completion while the user pauses at a line end
+    speculationTimer = new QTimer(this);
+    speculationTimer->setSingleShot(true);
+    connect(speculationTimer, &QTimer::timeout, this, [this]() {
+        triggerCompletion(CompletionEvent::IdleAtLineEnd);
+    });
+    budgetRefill.start();
 
     // Install event filter on editor
     if (editor) {
@@ -55,7 +81,14 @@ void CompletionWidget::setupStyle()
 
 void CompletionWidget::showCompletion(const QString &text)
 {
-    completion = text;
+    showCandidates(QStringList{text});
+}
+
+void CompletionWidget::showCandidates(const QStringList &suggestions)
+{
+    candidates = suggestions;
+    candidateIndex = 0;
+    completion = candidates.value(0);
     if (!completion.isEmpty()) {
         updatePosition();
         show();
@@ -63,10 +96,22 @@ void CompletionWidget::showCompletion(const QString &text)
     }
 }
 
+void CompletionWidget::cycleCandidate(int step)
+{
+    if (candidates.size() < 2) return;
+    candidateIndex = (candidateIndex + step + candidates.size()) % candidates.size();
+    completion = candidates.at(candidateIndex);
+    updatePosition();
+    update();
+}
+
 void CompletionWidget::hideCompletion()
 {
+    finishShown(CompletionEvent::Dismissed);
     hide();
     completion.clear();
+    candidates.clear();
+    candidateIndex = 0;
 }
 
 bool CompletionWidget::isVisible() const
@@ -87,6 +132,11 @@ void CompletionWidget::paintEvent(QPaintEvent *event)
         painter.setFont(editor->font());
         painter.setPen(Qt::gray);
         painter.drawText(rect().adjusted(5, 2, -5, -2), completion);
+        if (candidates.size() > 1) {
+            // Show which alternative is displayed, e.g. "2/3"
+            painter.drawText(rect().adjusted(5, 2, -5, -2), Qt::AlignRight | Qt::AlignVCenter,
+                             QString("%1/%2").arg(candidateIndex + 1).arg(candidates.size()));
+        }
     }
 }
 
@@ -101,6 +151,9 @@ void CompletionWidget::updatePosition()
     // Calculate size based on completion text
     QFontMetrics fm(editor->font());
     int width = fm.horizontalAdvance(completion) + 20;
+    if (candidates.size() > 1) {
+        width += fm.horizontalAdvance(QString(" %1/%2").arg(candidates.size()).arg(candidates.size()));
+    }
     int height = fm.height() + 10;
 
     // Adjust position to stay within editor bounds
@@ -112,129 +165,414 @@ void CompletionWidget::updatePosition()
     setGeometry(editor->mapFromGlobal(pos).x(), cursorRect.bottom() + 5, width, height);
 }
 
-QString CompletionWidget::getContextAroundCursor()
+QJsonObject CompletionWidget::requestBody(const QString &prompt) const
 {
-    if (!editor) return QString();
+    QJsonObject message;
+    message["role"] = "user";
+    message["content"] = prompt;
 
-    QTextCursor cursor = editor->textCursor();
-    QTextDocument *doc = editor->document();
-    
-    // Get text before cursor
-    cursor.movePosition(QTextCursor::Left, QTextCursor::MoveAnchor, CONTEXT_CHARS);
-    int start = qMax(0, cursor.position());
-    cursor.movePosition(QTextCursor::Right, QTextCursor::KeepAnchor, CONTEXT_CHARS);
-    
-    return doc->toPlainText().mid(start, CONTEXT_CHARS);
+    QJsonArray messages;
+    messages.append(message);
+
+    QJsonObject json;
+    json["model"] = model;
+    json["messages"] = messages;
+    json["temperature"] = 0.3;
+    json["max_tokens"] = MAX_COMPLETION_TOKENS;
+    json["n"] = CANDIDATE_COUNT;
+    json["stop"] = QJsonArray{";", "}", "{"};
+    return json;
 }
 
-QString CompletionWidget::createPrompt(const QString &context)
+QByteArray CompletionWidget::cacheKey(const QString &typedAhead) const
 {
-    return QString(
-        "You are an expert C++ code completion assistant. Analyze the context and provide a completion that:\n"
-        "1. Matches the coding style in the context\n"
-        "2. Uses modern C++ features when appropriate\n"
-        "3. Considers variable names and types from the context\n"
-        "4. Completes the current statement or block\n"
-        "5. Is concise and follows best practices\n\n"
-        "Provide ONLY the completion code, no explanations. Context:\n\n%1").arg(context);
+    return model.toUtf8() + '\0' + contextBuilder->contextKey(typedAhead);
 }
 
-void CompletionWidget::requestCompletion()
+QStringList CompletionWidget::cachedCandidates(const QByteArray &key)
 {
-    QString context = getContextAroundCursor();
-    if (context.isEmpty()) return;
+    CachedCompletion *entry = cache.object(key);
+    if (!entry) return QStringList();
+    if (entry->age.elapsed() > CACHE_TTL_MS) {
+        cache.remove(key);
+        return QStringList();
+    }
+    return entry->candidates;
+}
 
-    // Read API key from .env file
-    QString apiKey;
-    QString envPath = QDir::currentPath() + "/.env";
-    QFile envFile(envPath);
-    
-    qDebug() << "Looking for .env file at:" << envPath;
-    
-    if (envFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        QTextStream in(&envFile);
-        while (!in.atEnd()) {
-            QString line = in.readLine().trimmed();
-            if (line.startsWith("OPENAI_API_KEY=")) {
-                apiKey = line.mid(15).trimmed();  // Skip "OPENAI_API_KEY=" (15 characters)
-                // Remove any quotes if present
-                if (apiKey.startsWith('"') && apiKey.endsWith('"')) {
-                    apiKey = apiKey.mid(1, apiKey.length() - 2);
-                }
-                if (apiKey.startsWith("'") && apiKey.endsWith("'")) {
-                    apiKey = apiKey.mid(1, apiKey.length() - 2);
-                }
-                qDebug() << "Found API key, length:" << apiKey.length();
-                break;
-            }
+bool CompletionWidget::showCached()
+{
+    QStringList cached = cachedCandidates(cacheKey());
+    if (cached.isEmpty()) return false;
+
+    ++cacheHits;
+    qDebug() << "Completion served from cache;" << cacheHits << "hits from" << speculations << "speculative requests";
+    CompletionEvent event = newEvent(cacheKey(), false);
+    event.source = CompletionEvent::Cache;
+    showRecorded(event, cached);
+    return true;
+}
+
+void CompletionWidget::triggerCompletion(CompletionEvent::Trigger trigger)
+{
+    triggered.restart();
+    triggerEvent = CompletionEvent();
+    triggerEvent.trigger = trigger;
+    telemetry->start(&triggerEvent);
+    if (telemetry->mode() == CompletionTelemetry::Replay) {
+        captureContext(&triggerEvent);
+    }
+
+    switch (trigger) {
+    case CompletionEvent::TypingPause:
+        requestCompletion();
+        break;
+    case CompletionEvent::IdleAtLineEnd:
+        speculate();
+        break;
+    case CompletionEvent::NewLine:
+        // Show a prefetched completion at once, or start fetching one without waiting out the delay
+        if (showCached()) {
+            completionTimer->stop();
+        } else {
+            prefetch(QString());
         }
-        envFile.close();
-    } else {
-        qDebug() << "Failed to open .env file:" << envFile.errorString();
+        break;
     }
+}
 
-    if (apiKey.isEmpty()) {
+CompletionEvent CompletionWidget::newEvent(const QByteArray &key, bool speculative) const
+{
+    CompletionEvent event = triggerEvent;
+    event.contextHash = QCryptographicHash::hash(key, QCryptographicHash::Sha1);
+    event.backend = model + '@' + client->endpoint().host();
+    event.speculative = speculative;
+    event.queueMs = triggered.elapsed();
+    return event;
+}
+
+void CompletionWidget::captureContext(CompletionEvent *event) const
+{
+    if (!editor) return;
+
+    QTextDocument *document = editor->document();
+    const int position = editor->textCursor().position();
+    QTextCursor range(document);
+    range.setPosition(qMax(0, position - CompletionTelemetry::MAX_PREFIX_CHARS));
+    range.setPosition(position, QTextCursor::KeepAnchor);
+    event->prefix = range.selectedText().replace(QChar::ParagraphSeparator, '\n');
+    range.setPosition(position);
+    range.setPosition(qMin(document->characterCount() - 1, position + CompletionTelemetry::MAX_SUFFIX_CHARS),
+                      QTextCursor::KeepAnchor);
+    event->suffix = range.selectedText().replace(QChar::ParagraphSeparator, '\n');
+}
+
+void CompletionWidget::showRecorded(const CompletionEvent &event, const QStringList &suggestions)
+{
+    finishShown(CompletionEvent::Dismissed);
+    shownEvent = event;
+    shownEvent.candidates = suggestions.size();
+    showingEvent = true;
+    showCandidates(suggestions);
+}
+
+void CompletionWidget::finishShown(CompletionEvent::Outcome outcome)
+{
+    if (!showingEvent) return;
+    showingEvent = false;
+    shownEvent.outcome = outcome;
+    if (outcome == CompletionEvent::Accepted) {
+        shownEvent.acceptedIndex = candidateIndex;
+    }
+    telemetry->record(shownEvent);
+}
+
+void CompletionWidget::requestCompletion()
+{
+    if (showCached()) return;
+
+    // A prefetch for this context is already on its way and is shown when it lands
+    const QByteArray key = cacheKey();
+    for (const QByteArray &pending : qAsConst(requestKeys)) {
+        if (pending == key) return;
+    }
+
+    QString prompt = contextBuilder->buildPrompt();
+    if (prompt.isEmpty()) return;
+
+    if (Settings::instance()->snapshot()->apiKey.isEmpty()) {
         qDebug() << "No API key found in .env file";
         return;
     }
 
-    // Prepare the request
-    QNetworkRequest request(QUrl("https://api.openai.com/v1/chat/completions"));
-    request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
-    request.setRawHeader("Authorization", QString("Bearer %1").arg(apiKey).toUtf8());
+    QJsonObject json = requestBody(prompt);
+    qDebug() << "Sending request to OpenAI API, prompt tokens:" << contextBuilder->lastPromptTokens();
+    qDebug() << "Request URL:" << client->endpoint().toString();
+    qDebug() << "Request data:" << QString::fromUtf8(QJsonDocument(json).toJson());
 
-    // Prepare the chat completion request
-    QJsonObject message;
-    message["role"] = "user";
-    message["content"] = createPrompt(context);
+    CompletionEvent event = newEvent(key, false);
+    event.promptTokens = contextBuilder->lastPromptTokens();
+    quint64 id = client->send(json);
+    latestInteractive = id;
+    requestKeys.insert(id, key);
+    pendingEvents.insert(id, event);
+}
 
-    QJsonArray messages;
-    messages.append(message);
+void CompletionWidget::speculate()
+{
+    if (!editor || isVisible()) return;
 
-    QJsonObject json;
-    json["model"] = model;
-    json["messages"] = messages;
-    json["temperature"] = 0.3;
-    json["max_tokens"] = 50;
-    json["stop"] = QJsonArray{";", "}", "{"};
+    // At the end of a non-empty line the next context is most likely a fresh line below it
+    QTextCursor cursor = editor->textCursor();
+    if (cursor.hasSelection() || !cursor.atBlockEnd() || cursor.block().text().trimmed().isEmpty()) return;
+    prefetch("\n");
+}
 
-    QJsonDocument doc(json);
-    QByteArray data = doc.toJson();
-    qDebug() << "Sending request to OpenAI API...";
-    qDebug() << "Request URL:" << request.url().toString();
-    qDebug() << "Request data:" << QString::fromUtf8(data);
-    
-    networkManager->post(request, data);
+void CompletionWidget::prefetch(const QString &typedAhead)
+{
+    if (speculationBudget <= 0 || Settings::instance()->snapshot()->apiKey.isEmpty()) return;
+
+    const QByteArray key = cacheKey(typedAhead);
+    if (!cachedCandidates(key).isEmpty()) return;
+    for (const QByteArray &pending : qAsConst(requestKeys)) {
+        if (pending == key) return;
+    }
+
+    QString prompt = contextBuilder->buildPrompt(typedAhead);
+    if (prompt.isEmpty()) return;
+    CompletionEvent event = newEvent(key, true);
+    event.promptTokens = contextBuilder->lastPromptTokens();
+
+    // Charge the prompt and the most the reply can cost against the budget
+    const int cost = contextBuilder->lastPromptTokens() + MAX_COMPLETION_TOKENS * CANDIDATE_COUNT;
+    if (!takeSpeculationBudget(cost)) {
+        qDebug() << "Speculation budget exhausted, skipping prefetch";
+        return;
+    }
+
+    quint64 id = client->send(requestBody(prompt), CompletionClient::Speculative);
+    if (id == 0) {
+        budgetTokens += cost;  // Not sent, so not spent
+        return;
+    }
+    ++speculations;
+    requestKeys.insert(id, key);
+    speculativeRequests.insert(id);
+    pendingEvents.insert(id, event);
+}
+
+bool CompletionWidget::takeSpeculationBudget(int tokens)
+{
+    // Token bucket holding at most one minute of budget
+    budgetTokens = qMin(double(speculationBudget),
+                        budgetTokens + budgetRefill.restart() * speculationBudget / 60000.0);
+    if (budgetTokens < tokens) return false;
+    budgetTokens -= tokens;
+    return true;
+}
+
+void CompletionWidget::handleCompletionReply(quint64 id, const QJsonObject &obj, const RequestTiming &timing)
+{
+    const QByteArray key = requestKeys.take(id);
+    const bool speculative = speculativeRequests.remove(id);
+    qDebug() << (speculative ? "Speculative response" : "Response") << "from OpenAI API in" << timing.totalMs << "ms:";
+    qDebug() << "Response:" << QJsonDocument(obj).toJson(QJsonDocument::Compact);
+
+    CompletionEvent event = pendingEvents.take(id);
+    event.connectMs = timing.connectMs;
+    event.ttfbMs = timing.ttfbMs;
+    event.totalMs = timing.totalMs;
+    event.attempts = timing.attempts;
+    if (timing.hedged) {
+        event.backend = model + '@' + client->alternateEndpoint().host();
+    }
+    // The reported usage beats the local estimate when the endpoint sends it
+    QJsonObject usage = obj["usage"].toObject();
+    event.completionTokens = usage["completion_tokens"].toInt(-1);
+    if (usage["prompt_tokens"].toInt() > 0) {
+        event.promptTokens = usage["prompt_tokens"].toInt();
+    }
+
+    if (obj.contains("choices") && obj["choices"].isArray()) {
+        QStringList suggestions;
+        for (const QJsonValue &choice : obj["choices"].toArray()) {
+            suggestions.append(choice.toObject()["message"].toObject()["content"].toString());
+        }
+        QStringList ranked = rankCandidates(suggestions);
+        if (ranked.isEmpty()) {
+            telemetry->record(event);
+            return;
+        }
+
+        if (!key.isEmpty()) {
+            CachedCompletion *entry = new CachedCompletion;
+            entry->candidates = ranked;
+            entry->age.start();
+            cache.insert(key, entry);
+        }
+        // A prefetch only shows once the user has arrived at the context it was made for,
+        // and a reply only while its request is the latest and the cursor has not moved on
+        if (!speculative && id == latestInteractive && key == cacheKey()) {
+            showRecorded(event, ranked);
+        } else if (speculative && !isVisible() && key == cacheKey()) {
+            ++cacheHits;
+            showRecorded(event, ranked);
+        } else {
+            event.candidates = ranked.size();
+            telemetry->record(event);
+        }
+    } else {
+        telemetry->record(event);
+    }
+}
+
+void CompletionWidget::handleCompletionFailure(quint64 id, int statusCode, const QString &error,
+                                               const RequestTiming &timing)
+{
+    const QByteArray key = requestKeys.take(id);
+    qDebug() << "Completion request failed after" << timing.attempts << "attempts:"
+             << statusCode << error;
+
+    CompletionEvent event = pendingEvents.take(id);
+    event.connectMs = timing.connectMs;
+    event.ttfbMs = timing.ttfbMs;
+    event.totalMs = timing.totalMs;
+    event.attempts = timing.attempts;
+    event.statusCode = statusCode;
+    event.outcome = CompletionEvent::Failed;
+    telemetry->record(event);
+
+    // A failure only matters if the user is still waiting on it
+    const bool speculative = speculativeRequests.remove(id);
+    if (key != cacheKey() || (!speculative && id != latestInteractive)) return;
+
+    // Fall back to completing the current word from identifiers in the document
+    QStringList local = localCandidates();
+    if (!local.isEmpty()) {
+        event.source = CompletionEvent::Local;
+        event.outcome = CompletionEvent::NotShown;
+        showRecorded(event, local);
+    }
 }
 
-void CompletionWidget::handleNetworkReply(QNetworkReply *reply)
+QStringList CompletionWidget::localCandidates() const
 {
-    QString response = reply->readAll();
-    qDebug() << "Response from OpenAI API:";
-    qDebug() << "Status code:" << reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
-    qDebug() << "Response:" << response;
+    if (!editor) return QStringList();
+
+    static const QRegularExpression partialWord(QStringLiteral("[A-Za-z_]\\w*$"));
+    static const QRegularExpression identifier(QStringLiteral("[A-Za-z_]\\w*"));
 
-    if (reply->error() == QNetworkReply::NoError) {
-        QJsonDocument doc = QJsonDocument::fromJson(response.toUtf8());
-        QJsonObject obj = doc.object();
-        
-        if (obj.contains("choices") && obj["choices"].isArray()) {
-            QString suggestion = obj["choices"].toArray().first()
-                                  .toObject()["message"].toObject()["content"].toString();
-            if (!suggestion.isEmpty()) {
-                showCompletion(suggestion.trimmed());
+    QTextCursor cursor = editor->textCursor();
+    QString before = cursor.block().text().left(cursor.positionInBlock());
+    QString prefix = partialWord.match(before).captured();
+    if (prefix.length() < 2) return QStringList();
+
+    // Only the lines around the cursor are scanned, so a failure costs the same on any file size
+    QHash<QString, int> counts;
+    QTextBlock block = cursor.block();
+    for (int i = 0; i < LOCAL_SCAN_LINES && block.previous().isValid(); ++i) {
+        block = block.previous();
+    }
+    for (int i = 0; i <= 2 * LOCAL_SCAN_LINES && block.isValid(); ++i, block = block.next()) {
+        QRegularExpressionMatchIterator it = identifier.globalMatch(block.text());
+        while (it.hasNext()) {
+            QString word = it.next().captured();
+            if (word.length() > prefix.length() && word.startsWith(prefix)) {
+                ++counts[word];
             }
         }
+    }
+
+    QStringList words = counts.keys();
+    std::sort(words.begin(), words.end(), [&counts](const QString &a, const QString &b) {
+        return counts.value(a) != counts.value(b) ? counts.value(a) > counts.value(b) : a < b;
+    });
+
+    QStringList suggestions;
+    for (const QString &word : words.mid(0, CANDIDATE_COUNT)) {
+        suggestions.append(word.mid(prefix.length()));
+    }
+    return suggestions;
+}
+
+QStringList CompletionWidget::rankCandidates(const QStringList &suggestions)
+{
+    // Identical suggestions (ignoring whitespace) vote for each other; more votes rank first
+    QStringList unique;
+    QStringList keys;
+    QVector<int> votes;
+    for (const QString &suggestion : suggestions) {
+        QString text = suggestion.trimmed();
+        if (text.isEmpty()) continue;
+        QString key = text.simplified();
+        int index = keys.indexOf(key);
+        if (index >= 0) {
+            ++votes[index];
+        } else {
+            unique.append(text);
+            keys.append(key);
+            votes.append(1);
+        }
+    }
+
+    QVector<int> order(unique.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(),
+                     [&votes](int a, int b) { return votes[a] > votes[b]; });
+
+    QStringList ranked;
+    for (int index : order) {
+        ranked.append(unique.at(index));
+    }
+    return ranked;
+}
+
+void CompletionWidget::applySettings()
+{
+    SettingsPtr settings = Settings::instance()->snapshot();
+
+    client->setApiKey(settings->apiKey);
+    client->setEndpoint(settings->endpoint);
+    client->setAlternateEndpoint(settings->alternateEndpoint);
+    client->setDeadline(settings->deadlineMs);
+    client->setMaxAttempts(settings->maxAttempts);
+    client->setHedgingEnabled(settings->hedging);
+    if (settings->keepWarm == "never") {
+        client->setKeepWarmPolicy(CompletionClient::NoKeepWarm);
+    } else if (settings->keepWarm == "always") {
+        client->setKeepWarmPolicy(CompletionClient::KeepWarm, settings->keepWarmIdleMs);
     } else {
-        qDebug() << "Network error:" << reply->errorString();
-        qDebug() << "Error details:" << response;
+        client->setKeepWarmPolicy(CompletionClient::WarmOnStartup);
+    }
+    contextBuilder->setTokenBudget(settings->tokenBudget);
+    if (settings->telemetry == "off") {
+        telemetry->setMode(CompletionTelemetry::Off);
+    } else if (settings->telemetry == "replay") {
+        telemetry->setMode(CompletionTelemetry::Replay);
+    } else {
+        telemetry->setMode(CompletionTelemetry::Metrics);
+    }
+    telemetry->setDirectory(settings->telemetryDir);
+    if (speculationBudget != settings->speculationBudget) {
+        speculationBudget = settings->speculationBudget;
+        budgetTokens = speculationBudget;
     }
-    reply->deleteLater();
+
+    // Keep the current model if it is still offered, otherwise use the new default
+    if (!settings->models.contains(model)) {
+        model = settings->models.value(0);
+        emit modelChanged(model);
+    }
+}
+
+QStringList CompletionWidget::availableModels() const
+{
+    return Settings::instance()->snapshot()->models;
 }
 
 void CompletionWidget::setModel(const QString &newModel)
 {
-    if (AVAILABLE_MODELS.contains(newModel) && model != newModel) {
+    if (availableModels().contains(newModel) && model != newModel) {
         model = newModel;
         emit modelChanged(model);
     }
@@ -245,6 +583,11 @@ QString CompletionWidget::currentModel() const
     return model;
 }
 
+void CompletionWidget::setContextTokenBudget(int tokens)
+{
+    contextBuilder->setTokenBudget(tokens);
+}
+
 bool CompletionWidget::eventFilter(QObject *obj, QEvent *event)
 {
     if (obj == editor) {
@@ -252,11 +595,30 @@ bool CompletionWidget::eventFilter(QObject *obj, QEvent *event)
             QKeyEvent *keyEvent = static_cast<QKeyEvent*>(event);
             
             if (isVisible()) {
-                if (keyEvent->key() == Qt::Key_Tab) {
+                // A bare modifier press leads up to a shortcut such as Alt+], so it keeps the popup
+                switch (keyEvent->key()) {
+                case Qt::Key_Alt:
+                case Qt::Key_AltGr:
+                case Qt::Key_Shift:
+                case Qt::Key_Control:
+                case Qt::Key_Meta:
+                    return false;
+                default:
+                    break;
+                }
+
+                // Only plain Alt cycles; Ctrl+Alt+[ and Ctrl+Alt+] fold the code
+                if (keyEvent->modifiers() == Qt::AltModifier
+                    && (keyEvent->key() == Qt::Key_BracketRight || keyEvent->key() == Qt::Key_BracketLeft)) {
+                    // Cycle through alternative candidates
+                    cycleCandidate(keyEvent->key() == Qt::Key_BracketRight ? 1 : -1);
+                    return true;
+                } else if (keyEvent->key() == Qt::Key_Tab) {
                     // Accept completion
                     if (!completion.isEmpty()) {
                         QTextCursor cursor = editor->textCursor();
                         cursor.insertText(completion);
+                        finishShown(CompletionEvent::Accepted);
                         hideCompletion();
                     }
                     return true;
@@ -272,6 +634,7 @@ bool CompletionWidget::eventFilter(QObject *obj, QEvent *event)
             
             // Reset and restart completion timer on relevant keys
             completionTimer->stop();
+            speculationTimer->start(SPECULATION_IDLE_MS);
             if (keyEvent->key() == Qt::Key_Space || 
                 keyEvent->key() == Qt::Key_Return || 
                 keyEvent->key() == Qt::Key_Period ||
@@ -279,6 +642,12 @@ bool CompletionWidget::eventFilter(QObject *obj, QEvent *event)
                 keyEvent->key() == Qt::Key_Colon) {
                 completionTimer->start(COMPLETION_DELAY);
             }
+            if (keyEvent->key() == Qt::Key_Return || keyEvent->key() == Qt::Key_Enter) {
+                // Once the new line exists
+                QTimer::singleShot(0, this, [this]() {
+                    triggerCompletion(CompletionEvent::NewLine);
+                });
+            }
         }
     }
     return QFrame::eventFilter(obj, event);
@@ -0,0 +1,373 @@
+#include "contextbuilder.h"
+#include <QCryptographicHash>
+#include <QTextDocument>
+#include <QRegularExpression>
+#include <QSet>
+#include <algorithm>
+
+const QString ContextBuilder::INSTRUCTION = QStringLiteral(
+    "You are an expert C++ code completion assistant. Analyze the context and provide a completion that:\n"
+    "1. Matches the coding style in the context\n"
+    "2. Uses modern C++ features when appropriate\n"
+    "3. Considers variable names and types from the context\n"
+    "4. Completes the current statement or block at <CURSOR>\n"
+    "5. Is concise and follows best practices\n\n"
+    "Provide ONLY the code to insert at <CURSOR>, no explanations.\n\n");
+
+static bool isWordChar(QChar c)
+{
+    return c.isLetter() || c == QLatin1Char('_');
+}
+
+int TokenCounter::count(const QString &text)
+{
+    int tokens = 0;
+    const int n = text.size();
+    int i = 0;
+    while (i < n) {
+        const QChar c = text.at(i);
+        int start = i;
+        if (isWordChar(c)) {
+            // Identifiers split into sub-words at '_' and lower-to-upper case boundaries
+            int wordStart = i;
+            ++i;
+            while (i < n && isWordChar(text.at(i))) {
+                const QChar prev = text.at(i - 1);
+                const QChar cur = text.at(i);
+                if (cur == QLatin1Char('_') || (prev.isLower() && cur.isUpper())) {
+                    tokens += qMax(1, (i - wordStart + 5) / 6);
+                    wordStart = cur == QLatin1Char('_') ? i + 1 : i;
+                }
+                ++i;
+            }
+            if (i > wordStart) {
+                tokens += qMax(1, (i - wordStart + 5) / 6);
+            }
+        } else if (c.isDigit()) {
+            while (i < n && text.at(i).isDigit()) ++i;
+            tokens += (i - start + 2) / 3;
+        } else if (c.isSpace()) {
+            while (i < n && text.at(i).isSpace()) ++i;
+            // A single space before a word merges into the word's token
+            if (i - start == 1 && c == QLatin1Char(' ') && i < n && isWordChar(text.at(i))) {
+                continue;
+            }
+            tokens += 1 + (i - start - 1) / 8;
+        } else {
+            while (i < n && !text.at(i).isLetterOrNumber() && !text.at(i).isSpace()
+                   && text.at(i) != QLatin1Char('_')) {
+                ++i;
+            }
+            tokens += (i - start + 1) / 2;
+        }
+    }
+    return tokens;
+}
+
+ContextBuilder::ContextBuilder(QTextEdit *editor, QObject *parent)
+    : QObject(parent), editor(editor), scopes(nullptr), budget(DEFAULT_TOKEN_BUDGET), promptTokens(0),
+      declarationsRevision(-1)
+{
+    if (editor) {
+        scopes = ScopeIndex::of(editor->document());
+        connect(editor->document(), &QTextDocument::contentsChange,
+                this, &ContextBuilder::recordEdit);
+    }
+}
+
+void ContextBuilder::setTokenBudget(int tokens)
+{
+    // Below this the instruction alone would use up the budget
+    budget = qMax(TokenCounter::count(INSTRUCTION) + MIN_CONTEXT_TOKENS, tokens);
+}
+
+int ContextBuilder::tokenBudget() const
+{
+    return budget;
+}
+
+int ContextBuilder::lastPromptTokens() const
+{
+    return promptTokens;
+}
+
+QString ContextBuilder::buildPrompt(const QString &typedAhead)
+{
+    if (!editor || editor->document()->isEmpty()) return QString();
+
+    QTextCursor cursor = editor->textCursor();
+    int remaining = qMax(0, budget - TokenCounter::count(INSTRUCTION));
+
+    // Pack in order of value: the text leading up to the cursor, the enclosing
+    // signature, the text after the cursor, file declarations, then recent edits.
+    int firstBlock = cursor.blockNumber();
+    int lastBlock = cursor.blockNumber();
+    QString prefix = takePrefix(cursor, remaining / 2, &firstBlock) + typedAhead;
+    remaining = qMax(0, remaining - TokenCounter::count(prefix));
+
+    int signatureBlock = -1;
+    QString signature = enclosingSignature(cursor, &signatureBlock);
+    int signatureTokens = TokenCounter::count(signature);
+    if (signatureBlock >= firstBlock || signatureTokens > remaining) {
+        signature.clear();
+    } else {
+        remaining -= signatureTokens;
+    }
+
+    QString suffix = takeSuffix(cursor, qMin(remaining, budget / 5), &lastBlock);
+    remaining = qMax(0, remaining - TokenCounter::count(suffix));
+
+    QString declarationText = takeDeclarations(prefix, firstBlock, lastBlock, remaining * 2 / 3);
+    remaining = qMax(0, remaining - TokenCounter::count(declarationText));
+
+    QString editText = takeRecentEdits(firstBlock, lastBlock, remaining);
+
+    QString prompt = INSTRUCTION;
+    if (!declarationText.isEmpty()) {
+        prompt += "// Declarations from this file:\n" + declarationText + "\n\n";
+    }
+    if (!editText.isEmpty()) {
+        prompt += "// Recently edited:\n" + editText + "\n\n";
+    }
+    if (!signature.isEmpty()) {
+        prompt += "// Enclosing function:\n" + signature + "\n\n";
+    }
+    prompt += "// Code:\n" + prefix + "<CURSOR>" + suffix;
+
+    promptTokens = TokenCounter::count(prompt);
+    return prompt;
+}
+
+QByteArray ContextBuilder::contextKey(const QString &typedAhead) const
+{
+    if (!editor) return QByteArray();
+
+    QTextCursor cursor = editor->textCursor();
+    QTextBlock block = cursor.block();
+    QString prefix = block.text().left(cursor.positionInBlock()) + typedAhead;
+    QTextBlock previous = block.previous();
+    for (int i = 0; i < KEY_PREFIX_LINES && previous.isValid(); ++i, previous = previous.previous()) {
+        prefix.prepend(previous.text() + '\n');
+    }
+    // Typed-ahead newlines push the oldest lines out, as they will once typed
+    QStringList lines = prefix.split('\n');
+    lines = lines.mid(qMax(0, lines.size() - KEY_PREFIX_LINES - 1));
+
+    QString suffix = block.text().mid(cursor.positionInBlock());
+    QTextBlock next = block.next();
+    for (int i = 0; i < KEY_SUFFIX_LINES && next.isValid(); ++i, next = next.next()) {
+        suffix += '\n' + next.text();
+    }
+    return QCryptographicHash::hash((lines.join('\n') + "<CURSOR>" + suffix).toUtf8(),
+                                    QCryptographicHash::Sha1);
+}
+
+QString ContextBuilder::takePrefix(const QTextCursor &cursor, int maxTokens, int *firstBlock) const
+{
+    QTextBlock block = cursor.block();
+    *firstBlock = block.blockNumber();
+    if (maxTokens <= 0) return QString();
+
+    QString head = block.text().left(cursor.positionInBlock());
+    int tokens = TokenCounter::count(head);
+    if (tokens > maxTokens) {
+        // A single huge line: keep its tail
+        head = head.right(maxTokens * 3);
+        tokens = TokenCounter::count(head);
+    }
+
+    QStringList lines{head};
+    for (block = block.previous(); block.isValid(); block = block.previous()) {
+        const QString line = block.text();
+        int lineTokens = TokenCounter::count(line) + 1;
+        if (tokens + lineTokens > maxTokens) break;
+        tokens += lineTokens;
+        lines.prepend(line);
+        *firstBlock = block.blockNumber();
+    }
+    return lines.join('\n');
+}
+
+QString ContextBuilder::takeSuffix(const QTextCursor &cursor, int maxTokens, int *lastBlock) const
+{
+    QTextBlock block = cursor.block();
+    QString tail = block.text().mid(cursor.positionInBlock());
+    int tokens = TokenCounter::count(tail);
+    if (tokens > maxTokens) {
+        tail = tail.left(qMax(0, maxTokens * 3));
+        tokens = TokenCounter::count(tail);
+    }
+
+    QStringList lines{tail};
+    *lastBlock = block.blockNumber();
+    for (block = block.next(); block.isValid(); block = block.next()) {
+        const QString line = block.text();
+        int lineTokens = TokenCounter::count(line) + 1;
+        if (tokens + lineTokens > maxTokens) break;
+        tokens += lineTokens;
+        lines.append(line);
+        *lastBlock = block.blockNumber();
+    }
+    return lines.join('\n');
+}
+
+QString ContextBuilder::headBefore(const QTextBlock &block, int position, int *blockNumber) const
+{
+    // Collect the text preceding an opening brace back to the previous statement
+    QString head;
+    QTextBlock current = block;
+    QString text = block.text().left(position);
+    *blockNumber = block.blockNumber();
+    while (current.isValid() && head.size() < MAX_SIGNATURE_CHARS) {
+        int boundary = -1;
+        for (int i = text.size() - 1; i >= 0; --i) {
+            const QChar c = text.at(i);
+            if (c == QLatin1Char(';') || c == QLatin1Char('{') || c == QLatin1Char('}')) {
+                boundary = i;
+                break;
+            }
+        }
+        if (text.trimmed().startsWith('#')) break;
+        head.prepend(text.mid(boundary + 1) + QLatin1Char(' '));
+        *blockNumber = current.blockNumber();
+        if (boundary >= 0) break;
+        current = current.previous();
+        text = current.text();
+    }
+    return head.simplified().right(MAX_SIGNATURE_CHARS);
+}
+
+QString ContextBuilder::enclosingSignature(const QTextCursor &cursor, int *blockNumber) const
+{
+    static const QRegularExpression controlHead(
+        QStringLiteral("^(if|else|for|while|do|switch|try|catch|class|struct|union|enum|namespace)\\b"));
+    static const QRegularExpression lambdaHead(QStringLiteral("\\]\\s*\\("));
+
+    // Walk out through the enclosing scopes until one opens a function body
+    QTextDocument *doc = editor->document();
+    int open = scopes->scopeStart(cursor.position());
+    while (open >= 0) {
+        QTextBlock block = doc->findBlock(open);
+        QString head = headBefore(block, open - block.position(), blockNumber);
+        if (head.contains('(') && !controlHead.match(head).hasMatch()
+            && !lambdaHead.match(head).hasMatch()) {
+            return head;
+        }
+        open = scopes->scopeStart(open);
+    }
+    *blockNumber = -1;
+    return QString();
+}
+
+void ContextBuilder::updateDeclarations()
+{
+    QTextDocument *doc = editor->document();
+    if (declarationsRevision == doc->revision()) return;
+    declarationsRevision = doc->revision();
+    declarations.clear();
+
+    // The scope index matches declarations as it rescans edited blocks, so this only collects them
+    int number = 0;
+    for (QTextBlock block = doc->begin(); block.isValid(); block = block.next(), ++number) {
+        ScopeBlockData *data = ScopeIndex::data(block);
+        if (!data || data->declaration.isEmpty()) continue;
+        if (data->declarationTokens < 0) {
+            data->declarationTokens = TokenCounter::count(data->declaration) + 1;
+        }
+        declarations.append({number, data->declaration, data->declarationTokens, 0});
+    }
+}
+
+QString ContextBuilder::takeDeclarations(const QString &prefix, int firstBlock, int lastBlock,
+                                         int maxTokens)
+{
+    if (maxTokens <= 0) return QString();
+    updateDeclarations();
+
+    static const QRegularExpression identifierPattern(QStringLiteral("[A-Za-z_]\\w{2,}"));
+    QSet<QString> usedIdentifiers;
+    QRegularExpressionMatchIterator it = identifierPattern.globalMatch(prefix);
+    while (it.hasNext()) {
+        usedIdentifiers.insert(it.next().captured());
+    }
+
+    // Rank declarations by how many identifiers they share with the code being written
+    QList<Declaration> candidates;
+    for (Declaration decl : qAsConst(declarations)) {
+        if (decl.blockNumber >= firstBlock && decl.blockNumber <= lastBlock) continue;
+        decl.score = decl.text.startsWith('#') ? 1 : 0;
+        QRegularExpressionMatchIterator words = identifierPattern.globalMatch(decl.text);
+        while (words.hasNext()) {
+            if (usedIdentifiers.contains(words.next().captured())) decl.score += 2;
+        }
+        candidates.append(decl);
+    }
+    std::stable_sort(candidates.begin(), candidates.end(),
+                     [](const Declaration &a, const Declaration &b) { return a.score > b.score; });
+
+    QList<Declaration> chosen;
+    int tokens = 0;
+    for (const Declaration &decl : qAsConst(candidates)) {
+        if (tokens + decl.tokens > maxTokens) continue;
+        tokens += decl.tokens;
+        chosen.append(decl);
+    }
+    std::sort(chosen.begin(), chosen.end(),
+              [](const Declaration &a, const Declaration &b) { return a.blockNumber < b.blockNumber; });
+
+    QStringList lines;
+    for (const Declaration &decl : qAsConst(chosen)) {
+        lines.append(decl.text);
+    }
+    return lines.join('\n');
+}
+
+QString ContextBuilder::takeRecentEdits(int firstBlock, int lastBlock, int maxTokens) const
+{
+    if (maxTokens <= 0) return QString();
+
+    QTextDocument *doc = editor->document();
+    QSet<int> taken;
+    QStringList regions;
+    int tokens = 0;
+    for (const QTextCursor &edit : recentEdits) {
+        int center = edit.blockNumber();
+        if (center >= firstBlock - 1 && center <= lastBlock + 1) continue;
+
+        QStringList lines;
+        for (int number = center - 1; number <= center + 1; ++number) {
+            QTextBlock block = doc->findBlockByNumber(number);
+            if (!block.isValid() || taken.contains(number)) continue;
+            lines.append(block.text());
+            taken.insert(number);
+        }
+        if (lines.isEmpty()) continue;
+
+        QString region = lines.join('\n');
+        int regionTokens = TokenCounter::count(region) + 2;
+        if (tokens + regionTokens > maxTokens) break;
+        tokens += regionTokens;
+        regions.append(region);
+    }
+    return regions.join("\n...\n");
+}
+
+void ContextBuilder::recordEdit(int position, int charsRemoved, int charsAdded)
+{
+    Q_UNUSED(charsRemoved);
+    QTextDocument *doc = editor->document();
+    QTextCursor edit(doc);
+    edit.setPosition(qBound(0, position + charsAdded, doc->characterCount() - 1));
+
+    // Keep one entry per line; cursors track their position as the document changes
+    for (int i = 0; i < recentEdits.size(); ++i) {
+        if (recentEdits.at(i).blockNumber() == edit.blockNumber()) {
+            recentEdits.removeAt(i);
+            break;
+        }
+    }
+    recentEdits.prepend(edit);
+    while (recentEdits.size() > MAX_RECENT_EDITS) {
+        recentEdits.removeLast();
+    }
+}
@@ -1,8 +1,19 @@
 #include "highlighter.h"
+#include <QTextDocument>
+#include <QTextBlock>
+#include <QDebug>
 
 Highlighter::Highlighter(QTextDocument *parent)
-    : QSyntaxHighlighter(parent)
+    : QSyntaxHighlighter(parent), restoring(false), restoreFirst(0), restoreLast(-1),
+      deferredNext(-1), mismatches(0)
 {
+    deferredTimer = new QTimer(this);
+    deferredTimer->setInterval(0);
+    connect(deferredTimer, &QTimer::timeout, this, &Highlighter::formatDeferred);
+    if (parent) {
+        connect(parent, &QTextDocument::contentsChange, this, &Highlighter::contentsChanged);
+    }
+
     // Keywords - Ocean blue
     keywordFormat.setForeground(QColor("#64B5F6"));  
     keywordFormat.setFontWeight(QFont::Bold);
@@ -92,8 +103,82 @@ Highlighter::Highlighter(QTextDocument *parent)
     commentEndExpression = QRegularExpression(QStringLiteral("\\*/"));
 }
 
+void Highlighter::restoreStates(const QVector<int> &states, int firstBlock, int lastBlock)
+{
+    deferredTimer->stop();
+    deferredNext = -1;
+    restoredStates = states;
+    restoreFirst = firstBlock;
+    restoreLast = lastBlock;
+    restoring = true;
+}
+
+void Highlighter::finishRestore()
+{
+    if (!restoring) return;
+    restoring = false;
+    restoredStates.clear();
+    mismatches = 0;
+    deferredNext = 0;
+    deferredTimer->start();
+}
+
+QVector<int> Highlighter::blockStates() const
+{
+    QVector<int> states;
+    if (!document()) return states;
+    states.reserve(document()->blockCount());
+    for (QTextBlock block = document()->begin(); block.isValid(); block = block.next()) {
+        states.append(block.userState());
+    }
+    return states;
+}
+
+void Highlighter::formatDeferred()
+{
+    QTextBlock block = document()->findBlockByNumber(deferredNext);
+    for (int i = 0; i < RESTORE_SLICE_BLOCKS && block.isValid(); ++i) {
+        if (deferredNext < restoreFirst || deferredNext > restoreLast) {
+            // A wrong restored state corrects itself here, as the change carries on to later blocks
+            const int restored = block.userState();
+            rehighlightBlock(block);
+            if (block.userState() != restored) ++mismatches;
+        }
+        block = block.next();
+        ++deferredNext;
+    }
+    if (block.isValid()) return;
+
+    qDebug() << "Restored highlighting complete," << mismatches << "block states were stale";
+    deferredTimer->stop();
+    deferredNext = -1;
+}
+
+void Highlighter::contentsChanged(int position, int charsRemoved, int charsAdded)
+{
+    Q_UNUSED(charsRemoved);
+    if (deferredNext < 0) return;
+
+    if (position == 0 && charsAdded >= document()->characterCount()) {
+        // New content was highlighted in full, so nothing is left deferred
+        deferredTimer->stop();
+        deferredNext = -1;
+        return;
+    }
+    // An edit above the pass shifts blocks up; step back so none are skipped
+    deferredNext = qMin(deferredNext, document()->findBlock(position).blockNumber());
+}
+
 void Highlighter::highlightBlock(const QString &text)
 {
+    if (restoring) {
+        const int number = currentBlock().blockNumber();
+        if (number < restoreFirst || number > restoreLast) {
+            setCurrentBlockState(restoredStates.value(number, 0));
+            return;
+        }
+    }
+
     // Apply regular highlighting rules
     for (const HighlightingRule &rule : qAsConst(highlightingRules)) {
         QRegularExpressionMatchIterator matchIterator = rule.pattern.globalMatch(text);
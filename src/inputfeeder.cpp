@@ -0,0 +1,97 @@
+#include "inputfeeder.h"
+#include <QDebug>
+
+InputFeeder::InputFeeder(QProcess *process, QObject *parent)
+    : QObject(parent), process(process), sent(0), lastPercent(-1), closeWhenDone(false)
+{
+    connect(process, &QProcess::started, this, &InputFeeder::writeMore);
+    connect(process, &QProcess::bytesWritten, this, &InputFeeder::writeMore);
+    // Each start begins with fresh input. The process is shared by compiles and runs, so
+    // resetting on finished() would race with a run started from the compile's finished()
+    connect(process, &QProcess::stateChanged, this, [this](QProcess::ProcessState state) {
+        if (state == QProcess::Starting) stop();
+    });
+}
+
+bool InputFeeder::feedFile(const QString &fileName, QString *error)
+{
+    stop();
+    input.setFileName(fileName);
+    if (!input.open(QIODevice::ReadOnly)) {
+        if (error) *error = input.errorString();
+        return false;
+    }
+
+    // A fed file ends the input, like a shell redirect
+    closeWhenDone = true;
+    if (process->state() == QProcess::Running) {
+        writeMore();
+    }
+    return true;
+}
+
+void InputFeeder::sendLine(const QString &line)
+{
+    queuedLines.append(line.toLocal8Bit());
+    queuedLines.append('\n');
+    if (process->state() == QProcess::Running) {
+        writeMore();
+    }
+}
+
+void InputFeeder::closeInput()
+{
+    closeWhenDone = true;
+    writeMore();
+}
+
+void InputFeeder::stop()
+{
+    if (input.isOpen()) {
+        input.close();
+    }
+    queuedLines.clear();
+    sent = 0;
+    lastPercent = -1;
+    closeWhenDone = false;
+}
+
+bool InputFeeder::isFeedingFile() const
+{
+    return input.isOpen();
+}
+
+void InputFeeder::writeMore()
+{
+    if (process->state() != QProcess::Running) return;
+
+    // Only refill once the child has drained below the high-water mark
+    while (process->bytesToWrite() < HIGH_WATER) {
+        if (input.isOpen()) {
+            QByteArray chunk = input.read(CHUNK_SIZE);
+            if (chunk.isEmpty()) {
+                input.close();
+                emit fileFinished();
+                continue;
+            }
+            process->write(chunk);
+            sent += chunk.size();
+
+            qint64 total = input.size();
+            int percent = total > 0 ? int(sent * 100 / total) : 100;
+            if (percent != lastPercent) {
+                lastPercent = percent;
+                emit progress(sent, total);
+            }
+        } else if (!queuedLines.isEmpty()) {
+            process->write(queuedLines);
+            queuedLines.clear();
+        } else {
+            if (closeWhenDone) {
+                closeWhenDone = false;
+                process->closeWriteChannel();
+            }
+            return;
+        }
+    }
+}
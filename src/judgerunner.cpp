@@ -0,0 +1,292 @@
+#include "judgerunner.h"
+#include "outputcomparator.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QCollator>
+#include <QElapsedTimer>
+#include <QThread>
+#include <algorithm>
+
+#ifdef Q_OS_UNIX
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#endif
+
+QString JudgeResult::verdictCode() const
+{
+    switch (verdict) {
+        case Accepted:
+            return "AC";
+        case WrongAnswer:
+            return "WA";
+        case TimeLimitExceeded:
+            return "TLE";
+        case MemoryLimitExceeded:
+            return "MLE";
+        case RuntimeError:
+            return "RE";
+        default:
+            return "IE";
+    }
+}
+
+JudgeRunner::JudgeRunner(QObject *parent)
+    : QObject(parent), cancelled(std::make_shared<std::atomic_bool>(false)),
+      timeLimitMs(DEFAULT_TIME_LIMIT_MS), memoryLimitMb(DEFAULT_MEMORY_LIMIT_MB),
+      total(0), completed(0), passed(0)
+{
+    qRegisterMetaType<JudgeResult>();
+    pool = new QThreadPool(this);
+    pool->setMaxThreadCount(QThread::idealThreadCount());
+}
+
+JudgeRunner::~JudgeRunner()
+{
+    cancel();
+    pool->waitForDone();
+}
+
+QList<JudgeCase> JudgeRunner::discoverCases(const QString &directory)
+{
+    QDir dir(directory);
+    QList<JudgeCase> cases;
+    const QStringList inputs = dir.entryList(QStringList{"*.in"}, QDir::Files);
+    for (const QString &input : inputs) {
+        const QString name = QFileInfo(input).completeBaseName();
+        for (const char *suffix : {".out", ".ans", ".expected"}) {
+            const QString expected = dir.filePath(name + suffix);
+            if (QFileInfo::exists(expected)) {
+                cases.append({name, dir.filePath(input), expected});
+                break;
+            }
+        }
+    }
+
+    // Natural order so case2 runs before case10
+    QCollator collator;
+    collator.setNumericMode(true);
+    std::sort(cases.begin(), cases.end(), [&collator](const JudgeCase &a, const JudgeCase &b) {
+        return collator.compare(a.name, b.name) < 0;
+    });
+    return cases;
+}
+
+void JudgeRunner::setTimeLimit(int ms)
+{
+    timeLimitMs = qMax(1, ms);
+}
+
+void JudgeRunner::setMemoryLimit(int megabytes)
+{
+    memoryLimitMb = qMax(1, megabytes);
+}
+
+bool JudgeRunner::isRunning() const
+{
+    return completed < total;
+}
+
+void JudgeRunner::cancel()
+{
+    cancelled->store(true);
+}
+
+void JudgeRunner::start(const QString &program, const QList<JudgeCase> &cases)
+{
+    if (isRunning()) return;
+
+    // A fresh flag so a previous cancel() does not leak into this run
+    cancelled = std::make_shared<std::atomic_bool>(false);
+    total = cases.size();
+    completed = 0;
+    passed = 0;
+    if (total == 0) {
+        emit finished(0, 0);
+        return;
+    }
+
+    for (const JudgeCase &testCase : cases) {
+        std::shared_ptr<std::atomic_bool> flag = cancelled;
+        int timeLimit = timeLimitMs;
+        int memoryLimit = memoryLimitMb;
+        pool->start([this, program, testCase, flag, timeLimit, memoryLimit]() {
+            JudgeResult result = runCase(program, testCase, timeLimit, memoryLimit, *flag);
+            QMetaObject::invokeMethod(this, [this, result]() { handleResult(result); },
+                                      Qt::QueuedConnection);
+        });
+    }
+}
+
+void JudgeRunner::handleResult(const JudgeResult &result)
+{
+    ++completed;
+    if (result.verdict == JudgeResult::Accepted) {
+        ++passed;
+    }
+    emit caseFinished(result);
+    if (completed == total) {
+        emit finished(passed, total);
+    }
+}
+
+JudgeResult JudgeRunner::runCase(const QString &program, const JudgeCase &testCase,
+                                 int timeLimitMs, int memoryLimitMb, const std::atomic_bool &cancelled)
+{
+    JudgeResult result;
+    result.name = testCase.name;
+
+#ifdef Q_OS_UNIX
+    OutputComparator comparator(testCase.expectedPath);
+    if (!comparator.isOpen()) {
+        result.detail = "Cannot open " + testCase.expectedPath;
+        return result;
+    }
+
+    // Everything the child needs is prepared before fork(); afterwards it may
+    // only make async-signal-safe calls.
+    const QByteArray programPath = QFile::encodeName(program);
+    int inputFd = ::open(QFile::encodeName(testCase.inputPath).constData(), O_RDONLY | O_CLOEXEC);
+    if (inputFd < 0) {
+        result.detail = "Cannot open " + testCase.inputPath;
+        return result;
+    }
+    // Both pipe ends are close-on-exec so cases forked in parallel never inherit
+    // each other's pipes; dup2() clears the flag on the child's stdout.
+    int outputPipe[2];
+#ifdef Q_OS_LINUX
+    int pipeStatus = ::pipe2(outputPipe, O_CLOEXEC);
+#else
+    int pipeStatus = ::pipe(outputPipe);
+    if (pipeStatus == 0) {
+        ::fcntl(outputPipe[0], F_SETFD, FD_CLOEXEC);
+        ::fcntl(outputPipe[1], F_SETFD, FD_CLOEXEC);
+    }
+#endif
+    if (pipeStatus != 0) {
+        ::close(inputFd);
+        result.detail = "Cannot create output pipe";
+        return result;
+    }
+
+    struct rlimit cpuLimit;
+    cpuLimit.rlim_cur = rlim_t((timeLimitMs + 999) / 1000);
+    cpuLimit.rlim_max = cpuLimit.rlim_cur + 1;
+    struct rlimit memoryLimit;
+    memoryLimit.rlim_cur = memoryLimit.rlim_max = rlim_t(memoryLimitMb) * 1024 * 1024;
+
+    QElapsedTimer wallClock;
+    wallClock.start();
+    pid_t pid = ::fork();
+    if (pid == 0) {
+        ::dup2(inputFd, STDIN_FILENO);
+        ::dup2(outputPipe[1], STDOUT_FILENO);
+        int devNull = ::open("/dev/null", O_WRONLY);
+        if (devNull >= 0) ::dup2(devNull, STDERR_FILENO);
+        ::setrlimit(RLIMIT_CPU, &cpuLimit);
+        ::setrlimit(RLIMIT_AS, &memoryLimit);
+        ::execl(programPath.constData(), programPath.constData(), static_cast<char *>(nullptr));
+        ::_exit(127);
+    }
+    ::close(inputFd);
+    ::close(outputPipe[1]);
+    if (pid < 0) {
+        ::close(outputPipe[0]);
+        result.detail = "fork() failed";
+        return result;
+    }
+
+    // Wall-clock cap catches programs that sleep or block instead of burning CPU
+    const qint64 wallLimitMs = qint64(timeLimitMs) * 2 + 1000;
+    bool wallTimeout = false;
+    char buffer[64 * 1024];
+    struct pollfd readable = {outputPipe[0], POLLIN, 0};
+    forever {
+        qint64 remaining = wallLimitMs - wallClock.elapsed();
+        if (remaining <= 0 || cancelled.load()) {
+            wallTimeout = remaining <= 0;
+            ::kill(pid, SIGKILL);
+            break;
+        }
+        int ready = ::poll(&readable, 1, int(qMin<qint64>(remaining, 100)));
+        if (ready < 0 && errno != EINTR) break;
+        if (ready <= 0) continue;
+
+        ssize_t count = ::read(outputPipe[0], buffer, sizeof(buffer));
+        if (count < 0 && errno == EINTR) continue;
+        if (count <= 0) break;
+        if (!comparator.hasMismatch()) {
+            comparator.feed(buffer, count);
+        }
+    }
+    ::close(outputPipe[0]);
+
+    // A program can close stdout and keep running, so reaping it is bounded by the wall clock too
+    int status = 0;
+    struct rusage usage = {};
+    bool killed = wallTimeout || cancelled.load();
+    unsigned long pollMs = 1;
+    forever {
+        pid_t waited = ::wait4(pid, &status, WNOHANG, &usage);
+        if (waited == pid) break;
+        if (waited < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (!killed && (wallClock.elapsed() >= wallLimitMs || cancelled.load())) {
+            wallTimeout = wallClock.elapsed() >= wallLimitMs;
+            killed = true;
+            ::kill(pid, SIGKILL);
+        }
+        QThread::msleep(pollMs);
+        pollMs = qMin<unsigned long>(pollMs * 2, WAIT_POLL_MAX_MS);
+    }
+    comparator.finish();
+
+    result.timeMs = qint64(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000
+                    + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000;
+    result.peakRssKb = usage.ru_maxrss;  // Kilobytes on Linux
+    const qint64 memoryLimitKb = qint64(memoryLimitMb) * 1024;
+    const bool signalled = WIFSIGNALED(status);
+
+    if (cancelled.load() && !wallTimeout) {
+        result.verdict = JudgeResult::InternalError;
+        result.detail = "Cancelled";
+    } else if (wallTimeout || result.timeMs > timeLimitMs
+               || (signalled && WTERMSIG(status) == SIGXCPU)) {
+        result.verdict = JudgeResult::TimeLimitExceeded;
+        if (wallTimeout) {
+            result.detail = QString("Wall time over %1 ms").arg(wallLimitMs);
+        }
+    } else if (result.peakRssKb > memoryLimitKb
+               || ((signalled || WEXITSTATUS(status) != 0) && result.peakRssKb * 4 >= memoryLimitKb * 3)) {
+        // Allocation failures under RLIMIT_AS surface as crashes close to the limit
+        result.verdict = JudgeResult::MemoryLimitExceeded;
+    } else if (signalled) {
+        result.verdict = JudgeResult::RuntimeError;
+        result.detail = QString("Killed by signal %1").arg(WTERMSIG(status));
+    } else if (WEXITSTATUS(status) != 0) {
+        result.verdict = JudgeResult::RuntimeError;
+        result.detail = WEXITSTATUS(status) == 127 ? QString("Cannot execute %1").arg(program)
+                                                   : QString("Exit code %1").arg(WEXITSTATUS(status));
+    } else if (comparator.hasMismatch()) {
+        result.verdict = JudgeResult::WrongAnswer;
+        result.detail = QString("First difference at token %1").arg(comparator.mismatchToken());
+    } else {
+        result.verdict = JudgeResult::Accepted;
+    }
+#else
+    Q_UNUSED(program);
+    Q_UNUSED(timeLimitMs);
+    Q_UNUSED(memoryLimitMb);
+    Q_UNUSED(cancelled);
+    result.detail = "Judge mode requires a POSIX system";
+#endif
+    return result;
+}
@@ -1,4 +1,8 @@
 #include "mainwindow.h"
+#include "settings.h"
+#include "sourcefile.h"
+#include "benchmarkharness.h"
+#include "sessionstore.h"
 #include <QFileDialog>
 #include <QMessageBox>
 #include <QMenuBar>
@@ -7,12 +11,19 @@
 #include <QVBoxLayout>
 #include <QSplitter>
 #include <QTemporaryFile>
-#include <QTextStream>
 #include <QDir>
 #include <QStatusBar>
+#include <QShortcut>
+#include <QScrollBar>
+#include <QTextBlock>
+#include <QInputDialog>
+#include <QCoreApplication>
+#include <QAbstractTextDocumentLayout>
+#include <QCloseEvent>
+#include <QTimer>
 
 MainWindow::MainWindow(QWidget *parent)
-    : QMainWindow(parent), isUntitled(true), isCompiling(false)
+    : QMainWindow(parent), isUntitled(true), isCompiling(false), buildingHeader(false), runMode(RunProgram)
 {
     setWindowTitle("Beach IDE");
     resize(1024, 768);
@@ -28,30 +39,30 @@ MainWindow::MainWindow(QWidget *parent)
     setupEditor();
     splitter->addWidget(editor);
 
-    // Setup compiler output with beach at night theme colors
-    compilerOutput = new QTextEdit;
-    compilerOutput->setReadOnly(true);
-    compilerOutput->setFont(QFont("Courier", 12));
-    compilerOutput->setStyleSheet(
-        "QTextEdit {"
-        "  background: qlineargradient(x1:0, y1:0, x2:0, y2:1,"
-        "                             stop:0 #1a2634, stop:0.3 #2a3d50,"    // Deep ocean gradient
-        "                             stop:0.7 #3d4d5e, stop:1 #4a5d70);"   // Sandy ocean floor
-        "  background-image: repeating-linear-gradient("                     // Wave pattern
-        "    0deg,"
-        "    rgba(210, 180, 140, 0.02),"  // Lighter sandy waves
-        "    rgba(210, 180, 140, 0.02) 8px,"
-        "    transparent 8px,"
-        "    transparent 16px"
-        "  );"
-        "  color: #E2E8F0;"              // Soft white text
-        "  border: 1px solid #d2b48c;"    // Sandy border
+    // Setup compiler output, styled with beach at night theme colors
+    compilerOutput = new OutputPane;
+
+    // Console line below the output feeds the running program's stdin
+    consoleInput = new QLineEdit;
+    consoleInput->setFont(QFont("Courier", 12));
+    consoleInput->setPlaceholderText("Program input (Enter to send, Ctrl+D to end input)");
+    consoleInput->setStyleSheet(
+        "QLineEdit {"
+        "  background-color: #1a2634;"  // Deep ocean
+        "  color: #E2E8F0;"            // Soft white text
+        "  border: 1px solid #d2b48c;"  // Sandy border
         "  border-radius: 4px;"
-        "  padding: 8px;"
-        "  selection-background-color: #4a5d70;"  // Ocean highlight
+        "  padding: 4px;"
         "}"
     );
-    splitter->addWidget(compilerOutput);
+
+    QWidget *outputArea = new QWidget;
+    QVBoxLayout *outputLayout = new QVBoxLayout(outputArea);
+    outputLayout->setContentsMargins(0, 0, 0, 0);
+    outputLayout->setSpacing(2);
+    outputLayout->addWidget(compilerOutput);
+    outputLayout->addWidget(consoleInput);
+    splitter->addWidget(outputArea);
 
     layout->addWidget(splitter);
     centralWidget->setLayout(layout);
@@ -130,11 +141,72 @@ MainWindow::MainWindow(QWidget *parent)
     connect(process, &QProcess::readyReadStandardOutput, this, &MainWindow::readCompilerOutput);
     connect(process, &QProcess::readyReadStandardError, this, &MainWindow::readCompilerOutput);
 
+    // Initialize stdin feeding for the run process
+    inputFeeder = new InputFeeder(process, this);
+    connect(inputFeeder, &InputFeeder::progress, this, &MainWindow::inputProgress);
+    connect(consoleInput, &QLineEdit::returnPressed, this, &MainWindow::sendConsoleLine);
+    QShortcut *endOfInput = new QShortcut(QKeySequence(Qt::CTRL + Qt::Key_D), consoleInput);
+    endOfInput->setContext(Qt::WidgetShortcut);
+    connect(endOfInput, &QShortcut::activated, this, &MainWindow::closeProgramInput);
+
+    // Initialize test case judge
+    judgeRunner = new JudgeRunner(this);
+    connect(judgeRunner, &JudgeRunner::caseFinished, this, &MainWindow::judgeCaseFinished);
+    connect(judgeRunner, &JudgeRunner::finished, this, &MainWindow::judgeFinished);
+
+    // Code folding and bracket matching share the document's scope index
+    folding = new CodeFolding(editor, this);
+    connect(folding, &CodeFolding::foldsChanged, this, [this]() {
+        foldSelections = folding->selections();
+        updateExtraSelections();
+    });
+
+    // Bounded undo history in place of the document's own stack
+    undoHistory = new UndoHistory(editor, this);
+    undoHistory->setMemoryLimit(qint64(Settings::instance()->snapshot()->undoMemoryLimitMb) * 1024 * 1024);
+
+    // Assembly of the current file, refreshed on save while the pane is open
+    assemblyView = new AssemblyView;
+    assemblyDock = new QDockWidget("Assembly", this);
+    assemblyDock->setObjectName("AssemblyDock");
+    assemblyDock->setWidget(assemblyView);
+    addDockWidget(Qt::RightDockWidgetArea, assemblyDock);
+    assemblyDock->hide();
+    connect(assemblyDock, &QDockWidget::visibilityChanged, this, [this](bool visible) {
+        if (visible) refreshAssembly();
+    });
+    connect(assemblyView, &AssemblyView::statusChanged, this, [this](const QString &message) {
+        statusBar()->showMessage(message, 2000);
+    });
+    connect(assemblyView, &AssemblyView::sourceLineSelected, this, &MainWindow::highlightEditorLine);
+    connect(editor, &QTextEdit::cursorPositionChanged, this, &MainWindow::editorCursorMoved);
+
+    // Project-wide find and replace; the open file is edited through the editor
+    replacePanel = new ReplacePanel;
+    replacePanel->setRoot(QDir::currentPath());
+    replaceDock = new QDockWidget("Replace in Project", this);
+    replaceDock->setObjectName("ReplaceDock");
+    replaceDock->setWidget(replacePanel);
+    addDockWidget(Qt::BottomDockWidgetArea, replaceDock);
+    replaceDock->hide();
+    connect(replacePanel, &ReplacePanel::replaceInOpenFile, this, [this](const ReplaceOptions &options) {
+        int count = ProjectReplace::replaceInDocument(editor->document(), options);
+        statusBar()->showMessage(QString("Replaced %1 matches in the open file").arg(count), 2000);
+    });
+    connect(replacePanel, &ReplacePanel::matchActivated, this, &MainWindow::openMatch);
+    connect(replacePanel, &ReplacePanel::statusChanged, this, [this](const QString &message) {
+        statusBar()->showMessage(message, 2000);
+    });
+
     // Initialize completion widget
     completionWidget = new CompletionWidget(editor);
 
     createActions();
     createMenus();
+
+    connect(Settings::instance(), &Settings::changed, this, &MainWindow::settingsChanged);
+
+    restoreSession();
 }
 
 void MainWindow::setupEditor()
@@ -178,32 +250,42 @@ void MainWindow::documentWasModified()
 
 bool MainWindow::saveFile(const QString &fileName)
 {
-    QFile file(fileName);
-    if (file.open(QFile::WriteOnly | QFile::Text)) {
-        QTextStream out(&file);
-        out << editor->toPlainText();
-        file.close();
-        
+    QString errorString;
+    if (SourceFile::write(fileName, editor->toPlainText(), &errorString)) {
         setCurrentFile(fileName);
         editor->document()->setModified(false);
         statusBar()->showMessage(tr("File saved"), 2000);
+        refreshAssembly();
+        saveHighlightStates();
         return true;
     }
     QMessageBox::warning(this, tr("Application"),
                         tr("Cannot write file %1:\n%2.")
                         .arg(QDir::toNativeSeparators(fileName),
-                             file.errorString()));
+                             errorString));
     return false;
 }
 
-void MainWindow::loadFile(const QString &fileName)
+void MainWindow::loadFile(const QString &fileName, int firstVisibleBlock, int lastVisibleBlock)
 {
-    QFile file(fileName);
-    if (file.open(QFile::ReadOnly | QFile::Text)) {
-        QTextStream in(&file);
-        editor->setPlainText(in.readAll());
-        file.close();
-        
+    QString text;
+    if (SourceFile::read(fileName, &text)) {
+        // With cached states only the visible blocks are highlighted now, the rest lazily
+        QVector<int> states;
+        bool restored = SessionStore::loadHighlightStates(SessionStore::contentHash(text),
+                                                          text.count('\n') + 1, &states);
+        if (restored) {
+            if (lastVisibleBlock < 0) {
+                lastVisibleBlock = firstVisibleBlock + editor->viewport()->height()
+                                   / qMax(1, editor->fontMetrics().lineSpacing());
+            }
+            highlighter->restoreStates(states, firstVisibleBlock - RESTORE_MARGIN_BLOCKS,
+                                       lastVisibleBlock + RESTORE_MARGIN_BLOCKS);
+        }
+        editor->setPlainText(text);
+        if (restored) highlighter->finishRestore();
+        undoHistory->clear();
+
         setCurrentFile(fileName);
         editor->document()->setModified(false);
         statusBar()->showMessage(tr("File loaded"), 2000);
@@ -222,10 +304,66 @@ void MainWindow::setCurrentFile(const QString &fileName)
         shownName = "untitled.cpp";
     }
     setWindowTitle(QString("%1[*] - Beach IDE").arg(QFileInfo(shownName).fileName()));
+
+    replacePanel->setOpenFile(currentFile);
+    replacePanel->setRoot(isUntitled ? QDir::currentPath() : QFileInfo(currentFile).absolutePath());
+}
+
+void MainWindow::openMatch(const QString &path, int line)
+{
+    if (isUntitled || QFileInfo(path).absoluteFilePath() != QFileInfo(currentFile).absoluteFilePath()) {
+        if (!maybeSave()) return;
+        loadFile(path);
+    }
+    QTextBlock block = editor->document()->findBlockByNumber(line - 1);
+    if (!block.isValid()) return;
+    editor->setTextCursor(QTextCursor(block));
+    editor->ensureCursorVisible();
+    editor->setFocus();
+}
+
+void MainWindow::restoreSession()
+{
+    Session session = SessionStore::load();
+    if (session.file.isEmpty() || !QFileInfo::exists(session.file)) return;
+
+    loadFile(session.file, session.firstVisibleBlock, session.lastVisibleBlock);
+    QTextCursor cursor = editor->textCursor();
+    cursor.setPosition(qBound(0, session.cursorPosition, editor->document()->characterCount() - 1));
+    editor->setTextCursor(cursor);
+    // The scroll range is only known once the document has been laid out
+    int scrollValue = session.scrollValue;
+    QTimer::singleShot(0, this, [this, scrollValue]() {
+        editor->verticalScrollBar()->setValue(scrollValue);
+    });
+}
+
+void MainWindow::saveHighlightStates()
+{
+    if (isUntitled || editor->document()->isModified()) return;
+    SessionStore::saveHighlightStates(SessionStore::contentHash(editor->toPlainText()),
+                                      highlighter->blockStates());
+}
+
+void MainWindow::closeEvent(QCloseEvent *event)
+{
+    Session session;
+    if (!isUntitled) {
+        session.file = QFileInfo(currentFile).absoluteFilePath();
+        session.cursorPosition = editor->textCursor().position();
+        session.scrollValue = editor->verticalScrollBar()->value();
+        session.firstVisibleBlock = editor->cursorForPosition(QPoint(0, 0)).blockNumber();
+        session.lastVisibleBlock = editor->cursorForPosition(
+            QPoint(0, editor->viewport()->height() - 1)).blockNumber();
+    }
+    SessionStore::save(session);
+    saveHighlightStates();
+    event->accept();
 }
 
 MainWindow::~MainWindow()
 {
+    judgeRunner->cancel();
     if (process->state() == QProcess::Running) {
         process->terminate();
         process->waitForFinished();
@@ -260,11 +398,83 @@ void MainWindow::createActions()
     connect(exitAct, SIGNAL(triggered()), this, SLOT(close()));
     fileMenu->addAction(exitAct);
 
+    QMenu *editMenu = menuBar()->addMenu("&Edit");
+    QAction *undoAct = new QAction("&Undo", this);
+    undoAct->setShortcuts(QKeySequence::Undo);
+    undoAct->setEnabled(false);
+    connect(undoAct, &QAction::triggered, undoHistory, &UndoHistory::undo);
+    connect(undoHistory, &UndoHistory::undoAvailable, undoAct, &QAction::setEnabled);
+    editMenu->addAction(undoAct);
+
+    QAction *redoAct = new QAction("&Redo", this);
+    redoAct->setShortcuts(QKeySequence::Redo);
+    redoAct->setEnabled(false);
+    connect(redoAct, &QAction::triggered, undoHistory, &UndoHistory::redo);
+    connect(undoHistory, &UndoHistory::redoAvailable, redoAct, &QAction::setEnabled);
+    editMenu->addAction(redoAct);
+
     QMenu *buildMenu = menuBar()->addMenu("&Build");
     QAction *runAct = new QAction("Compile and &Run", this);
     runAct->setShortcut(Qt::Key_F5);
     connect(runAct, SIGNAL(triggered()), this, SLOT(compileAndRun()));
     buildMenu->addAction(runAct);
+
+    QAction *judgeAct = new QAction("Run &Test Cases...", this);
+    judgeAct->setShortcut(QKeySequence(Qt::CTRL + Qt::Key_F5));
+    connect(judgeAct, SIGNAL(triggered()), this, SLOT(runTestCases()));
+    buildMenu->addAction(judgeAct);
+
+    QAction *benchmarkAct = new QAction("Micro-&benchmark Selection", this);
+    benchmarkAct->setShortcut(QKeySequence(Qt::CTRL + Qt::SHIFT + Qt::Key_B));
+    connect(benchmarkAct, SIGNAL(triggered()), this, SLOT(benchmarkSelection()));
+    buildMenu->addAction(benchmarkAct);
+
+    buildMenu->addSeparator();
+    QAction *inputAct = new QAction("Set Run &Input File...", this);
+    connect(inputAct, SIGNAL(triggered()), this, SLOT(chooseRunInput()));
+    buildMenu->addAction(inputAct);
+
+    clearInputAct = new QAction("&Clear Run Input File", this);
+    clearInputAct->setEnabled(false);
+    connect(clearInputAct, SIGNAL(triggered()), this, SLOT(clearRunInput()));
+    buildMenu->addAction(clearInputAct);
+
+    buildMenu->addSeparator();
+    profileMenu = buildMenu->addMenu("Build &Profile");
+    profileActionGroup = new QActionGroup(this);
+    profileActionGroup->setExclusive(true);
+    connect(profileActionGroup, &QActionGroup::triggered, this, &MainWindow::setBuildProfile);
+    populateProfileMenu();
+
+    QMenu *viewMenu = menuBar()->addMenu("&View");
+    QAction *assemblyAct = assemblyDock->toggleViewAction();
+    assemblyAct->setText("&Assembly");
+    assemblyAct->setShortcut(QKeySequence(Qt::CTRL + Qt::SHIFT + Qt::Key_A));
+    viewMenu->addAction(assemblyAct);
+
+    QAction *replaceAct = new QAction("&Replace in Project...", this);
+    replaceAct->setShortcut(QKeySequence(Qt::CTRL + Qt::SHIFT + Qt::Key_H));
+    connect(replaceAct, &QAction::triggered, this, [this]() {
+        replaceDock->show();
+        replaceDock->raise();
+        replacePanel->focusSearch(editor->textCursor().selectedText());
+    });
+    viewMenu->addAction(replaceAct);
+
+    viewMenu->addSeparator();
+    QAction *foldAct = new QAction("Toggle &Fold", this);
+    foldAct->setShortcut(QKeySequence(Qt::CTRL + Qt::ALT + Qt::Key_BracketLeft));
+    connect(foldAct, &QAction::triggered, folding, &CodeFolding::toggleFoldAtCursor);
+    viewMenu->addAction(foldAct);
+
+    QAction *foldAllAct = new QAction("Fold A&ll", this);
+    connect(foldAllAct, &QAction::triggered, folding, &CodeFolding::foldAll);
+    viewMenu->addAction(foldAllAct);
+
+    QAction *unfoldAllAct = new QAction("&Unfold All", this);
+    unfoldAllAct->setShortcut(QKeySequence(Qt::CTRL + Qt::ALT + Qt::Key_BracketRight));
+    connect(unfoldAllAct, &QAction::triggered, folding, &CodeFolding::unfoldAll);
+    viewMenu->addAction(unfoldAllAct);
 }
 
 void MainWindow::createMenus()
@@ -289,34 +499,147 @@ void MainWindow::createModelMenu()
     modelMenu = menuBar()->addMenu("AI Model");
     modelActionGroup = new QActionGroup(this);
     modelActionGroup->setExclusive(true);
+    populateModelMenu();
+
+    connect(modelActionGroup, &QActionGroup::triggered, this, &MainWindow::setCompletionModel);
+    connect(completionWidget, &CompletionWidget::modelChanged, this, &MainWindow::populateModelMenu);
+}
 
-    for (const QString &modelName : CompletionWidget::AVAILABLE_MODELS) {
+void MainWindow::populateModelMenu()
+{
+    // Actions are owned by the menu, so clearing it also removes them from the group
+    modelMenu->clear();
+    for (const QString &modelName : completionWidget->availableModels()) {
         QAction *action = modelMenu->addAction(modelName);
         action->setCheckable(true);
         action->setData(modelName);
         modelActionGroup->addAction(action);
-        
+
         if (modelName == completionWidget->currentModel()) {
             action->setChecked(true);
         }
     }
-
-    connect(modelActionGroup, &QActionGroup::triggered, this, &MainWindow::setCompletionModel);
 }
 
-void MainWindow::setCompletionModel()
+void MainWindow::setCompletionModel(QAction *action)
 {
-    QAction *action = qobject_cast<QAction*>(sender());
     if (action) {
         QString modelName = action->data().toString();
         completionWidget->setModel(modelName);
     }
 }
 
+void MainWindow::populateProfileMenu()
+{
+    SettingsPtr settings = Settings::instance()->snapshot();
+    activeProfile = settings->buildProfile(activeProfile).name;
+
+    profileMenu->clear();
+    for (const BuildProfile &profile : settings->buildProfiles) {
+        QAction *action = profileMenu->addAction(profile.name);
+        action->setCheckable(true);
+        action->setData(profile.name);
+        action->setToolTip(profile.flags.join(' '));
+        profileActionGroup->addAction(action);
+
+        if (profile.name == activeProfile) {
+            action->setChecked(true);
+        }
+    }
+}
+
+void MainWindow::setBuildProfile(QAction *action)
+{
+    if (action) {
+        activeProfile = action->data().toString();
+        statusBar()->showMessage(tr("Build profile: %1").arg(activeProfile), 2000);
+        refreshAssembly();
+    }
+}
+
+void MainWindow::refreshAssembly()
+{
+    if (!assemblyDock->isVisible()) return;
+    if (isUntitled) {
+        assemblyView->setPlainText("Save the file to see its assembly");
+        return;
+    }
+
+    // Same compiler and flags as Compile and Run, so the listing matches what runs
+    SettingsPtr settings = Settings::instance()->snapshot();
+    assemblyView->refresh(settings->compiler, settings->buildProfile(activeProfile).flags,
+                          currentFile, editor->toPlainText());
+}
+
+void MainWindow::editorCursorMoved()
+{
+    // Match the bracket after the cursor, or else the one before it
+    bracketSelections.clear();
+    ScopeIndex *scopes = ScopeIndex::of(editor->document());
+    int position = editor->textCursor().position();
+    int bracket = position;
+    int match = scopes->matchingBracket(bracket);
+    if (match < 0 && position > 0) {
+        bracket = position - 1;
+        match = scopes->matchingBracket(bracket);
+    }
+    if (match >= 0) {
+        for (int at : {bracket, match}) {
+            QTextEdit::ExtraSelection selection;
+            selection.format.setBackground(QColor("#4a5d70"));  // Ocean highlight
+            selection.format.setForeground(QColor("#FFD54F"));  // Sandy gold
+            selection.cursor = QTextCursor(editor->document());
+            selection.cursor.setPosition(at);
+            selection.cursor.movePosition(QTextCursor::NextCharacter, QTextCursor::KeepAnchor);
+            bracketSelections.append(selection);
+        }
+    }
+    updateExtraSelections();
+
+    if (assemblyDock->isVisible()) {
+        assemblyView->highlightSourceLine(editor->textCursor().blockNumber() + 1);
+    }
+}
+
+void MainWindow::updateExtraSelections()
+{
+    // Later kinds paint over earlier ones
+    editor->setExtraSelections(foldSelections + assemblySelections + bracketSelections);
+}
+
+void MainWindow::highlightEditorLine(int line)
+{
+    QTextBlock block = editor->document()->findBlockByNumber(line - 1);
+    if (!block.isValid()) return;
+
+    QTextEdit::ExtraSelection selection;
+    selection.format.setBackground(QColor("#4a5d70"));  // Ocean highlight
+    selection.format.setProperty(QTextFormat::FullWidthSelection, true);
+    selection.cursor = QTextCursor(block);
+    assemblySelections = {selection};
+    updateExtraSelections();
+
+    // Scroll the line into view without moving the editing cursor
+    QRectF rect = editor->document()->documentLayout()->blockBoundingRect(block);
+    QScrollBar *bar = editor->verticalScrollBar();
+    if (rect.top() < bar->value() || rect.bottom() > bar->value() + editor->viewport()->height()) {
+        bar->setValue(int(rect.top()) - editor->viewport()->height() / 3);
+    }
+}
+
+void MainWindow::settingsChanged()
+{
+    undoHistory->setMemoryLimit(qint64(Settings::instance()->snapshot()->undoMemoryLimitMb) * 1024 * 1024);
+    populateModelMenu();
+    populateProfileMenu();
+    refreshAssembly();
+}
+
 void MainWindow::newFile()
 {
     if (maybeSave()) {
         editor->clear();
+        undoHistory->clear();
         setCurrentFile(QString());
     }
 }
@@ -365,36 +688,263 @@ bool MainWindow::maybeSave()
 }
 
 void MainWindow::compileAndRun()
+{
+    startBuild(RunProgram, currentFile);
+}
+
+void MainWindow::runTestCases()
+{
+    if (judgeRunner->isRunning()) {
+        statusBar()->showMessage(tr("Test cases are still running"), 2000);
+        return;
+    }
+
+    QString startDirectory = judgeDirectory.isEmpty() ? QFileInfo(currentFile).absolutePath() : judgeDirectory;
+    QString directory = QFileDialog::getExistingDirectory(this, "Test Case Directory", startDirectory);
+    if (directory.isEmpty()) return;
+
+    judgeDirectory = directory;
+    startBuild(RunJudge, currentFile);
+}
+
+void MainWindow::benchmarkSelection()
+{
+    // The harness includes the file from disk, so it has to match the editor
+    if (isUntitled || editor->document()->isModified()) {
+        QMessageBox::warning(this, "Micro-benchmark", "Please save the file first");
+        return;
+    }
+
+    QString selection = editor->textCursor().selectedText();
+    selection.replace(QChar::ParagraphSeparator, '\n');
+    selection = selection.trimmed();
+    if (selection.isEmpty()) {
+        QMessageBox::information(this, "Micro-benchmark",
+                                 "Select a function or an expression to benchmark");
+        return;
+    }
+
+    // A selected function is called directly, or through a call the user writes
+    QString snippet = selection;
+    bool hasParameters = false;
+    QString function = BenchmarkHarness::functionName(selection, &hasParameters);
+    if (!function.isEmpty()) {
+        snippet = function + "()";
+        if (hasParameters) {
+            bool ok = false;
+            snippet = QInputDialog::getMultiLineText(
+                this, "Micro-benchmark",
+                "Setup statements run once; the last statement is timed.\n"
+                "Anything declared at file scope can be used.",
+                QString("std::vector<int> data(1000, 42);\n%1(data);").arg(function), &ok);
+            if (!ok || snippet.trimmed().isEmpty()) return;
+        }
+    }
+
+    QString setup, expression;
+    BenchmarkHarness::splitSnippet(snippet, &setup, &expression);
+    if (expression.isEmpty()) return;
+
+    QString harnessFile = QDir::temp().filePath(QString("beach-bench-%1.cpp")
+                                                .arg(QCoreApplication::applicationPid()));
+    QString error;
+    if (!SourceFile::write(harnessFile, BenchmarkHarness::generate(currentFile, setup, expression), &error)) {
+        QMessageBox::warning(this, "Micro-benchmark",
+                             QString("Cannot write %1:\n%2").arg(QDir::toNativeSeparators(harnessFile), error));
+        return;
+    }
+    benchmarkExpression = expression;
+    startBuild(RunBenchmark, harnessFile);
+}
+
+void MainWindow::startBuild(RunMode mode, const QString &source)
 {
     if (isUntitled || editor->document()->isModified()) {
         QMessageBox::warning(this, "Compile", "Please save the file first");
         return;
     }
 
-    compilerOutput->clear();
-    QString program = "g++";
-    QStringList arguments;
-    arguments << currentFile << "-o" << currentFile + ".out";
-    
+    compilerOutput->clearOutput();
+    runMode = mode;
+    buildSource = source;
+    buildOutput = source + ".out";
+    SettingsPtr settings = Settings::instance()->snapshot();
+    buildCompiler = settings->compiler;
+    buildFlags = settings->buildProfile(activeProfile).flags;
     isCompiling = true;
-    process->start(program, arguments);
+    buildTimer.start();
+    if (mode == RunBenchmark && !BenchmarkHarness::optimizes(buildFlags)) {
+        compilerOutput->appendOutput(QString("Note: build profile %1 does not optimize; timings will not reflect release code")
+                                     .arg(activeProfile));
+    }
+
+    // Build the precompiled header first when the include block or flags are new
+    header = PrecompiledHeader();
+    if (settings->precompiledHeaders) {
+        header = PrecompiledHeader(buildCompiler, buildFlags,
+                                   PrecompiledHeader::includeBlock(editor->toPlainText()));
+        if (header.hasFailed()) {
+            header = PrecompiledHeader();
+        } else if (header.isUpToDate()) {
+            header.markUsed();
+        } else if (!header.isNull()) {
+            QString error;
+            if (header.prepare(&error)) {
+                compilerOutput->appendOutput("Precompiling headers...");
+                buildingHeader = true;
+                process->start(buildCompiler, header.buildArguments());
+                return;
+            }
+            compilerOutput->appendOutput("Cannot prepare precompiled header: " + error);
+            header = PrecompiledHeader();
+        }
+    }
+    compileSource();
+}
+
+void MainWindow::compileSource()
+{
+    QStringList arguments = buildFlags;
+    if (!header.isNull()) {
+        arguments << header.compileArguments();
+    }
+    arguments << buildSource << "-o" << buildOutput;
+    compilerOutput->appendOutput(QString("%1 %2").arg(buildCompiler, arguments.join(' ')));
+    process->start(buildCompiler, arguments);
 }
 
 void MainWindow::runCompiledProgram()
 {
     QStringList args;
-    process->start(currentFile + ".out", args);
+    process->start(buildOutput, args);
+
+    if (!runInputFile.isEmpty()) {
+        QString error;
+        if (inputFeeder->feedFile(runInputFile, &error)) {
+            compilerOutput->appendOutput(QString("Reading input from %1")
+                                         .arg(QDir::toNativeSeparators(runInputFile)));
+        } else {
+            compilerOutput->appendOutput(QString("Cannot read input file %1: %2")
+                                         .arg(QDir::toNativeSeparators(runInputFile), error));
+        }
+    }
+}
+
+void MainWindow::chooseRunInput()
+{
+    QString startDirectory = runInputFile.isEmpty() ? QFileInfo(currentFile).absolutePath() : runInputFile;
+    QString fileName = QFileDialog::getOpenFileName(this, "Run Input File", startDirectory);
+    if (fileName.isEmpty()) return;
+
+    runInputFile = fileName;
+    clearInputAct->setEnabled(true);
+    statusBar()->showMessage(QString("Program input: %1").arg(QFileInfo(fileName).fileName()), 2000);
+}
+
+void MainWindow::clearRunInput()
+{
+    runInputFile.clear();
+    clearInputAct->setEnabled(false);
+    statusBar()->showMessage("Program input: console", 2000);
+}
+
+void MainWindow::sendConsoleLine()
+{
+    if (isCompiling || process->state() == QProcess::NotRunning) {
+        statusBar()->showMessage("No program is running", 2000);
+        return;
+    }
+
+    QString line = consoleInput->text();
+    compilerOutput->appendOutput("> " + line);
+    inputFeeder->sendLine(line);
+    consoleInput->clear();
+}
+
+void MainWindow::closeProgramInput()
+{
+    if (isCompiling || process->state() == QProcess::NotRunning) return;
+    inputFeeder->closeInput();
+    compilerOutput->appendOutput("> ^D");
+}
+
+void MainWindow::inputProgress(qint64 sent, qint64 total)
+{
+    if (total <= 0) return;
+    statusBar()->showMessage(QString("Feeding input: %1% of %2 MB")
+                             .arg(sent * 100 / total)
+                             .arg(total / (1024 * 1024)), 2000);
+}
+
+void MainWindow::runJudge()
+{
+    QList<JudgeCase> cases = JudgeRunner::discoverCases(judgeDirectory);
+    if (cases.isEmpty()) {
+        compilerOutput->appendOutput(QString("No test cases (*.in with .out, .ans or .expected) in %1")
+                                     .arg(QDir::toNativeSeparators(judgeDirectory)));
+        return;
+    }
+
+    SettingsPtr settings = Settings::instance()->snapshot();
+    judgeRunner->setTimeLimit(settings->judgeTimeLimitMs);
+    judgeRunner->setMemoryLimit(settings->judgeMemoryLimitMb);
+    compilerOutput->appendOutput(QString("Judging %1 test cases (%2 ms, %3 MB)...")
+                                 .arg(cases.size())
+                                 .arg(settings->judgeTimeLimitMs)
+                                 .arg(settings->judgeMemoryLimitMb));
+    judgeRunner->start(QFileInfo(buildOutput).absoluteFilePath(), cases);
+}
+
+void MainWindow::judgeCaseFinished(const JudgeResult &result)
+{
+    QString line = QString("%1  %2  %3 ms  %4 KB")
+                   .arg(result.verdictCode(), -3)
+                   .arg(result.name)
+                   .arg(result.timeMs)
+                   .arg(result.peakRssKb);
+    if (!result.detail.isEmpty()) {
+        line += "  " + result.detail;
+    }
+    compilerOutput->appendOutput(line);
+}
+
+void MainWindow::judgeFinished(int passed, int total)
+{
+    compilerOutput->appendOutput(QString("Passed %1/%2 test cases").arg(passed).arg(total));
 }
 
 void MainWindow::processFinished(int exitCode, QProcess::ExitStatus exitStatus)
 {
+    if (buildingHeader) {
+        buildingHeader = false;
+        const bool built = exitCode == 0 && exitStatus == QProcess::NormalExit;
+        if (!built || !header.commit()) {
+            // A header the compiler refused is not retried on every build
+            if (exitStatus == QProcess::NormalExit && exitCode != 0) header.markFailed();
+            compilerOutput->appendOutput("Precompiled header failed, compiling without it");
+            header = PrecompiledHeader();
+        }
+        compileSource();
+        return;
+    }
+
     if (isCompiling) {
         isCompiling = false;
         if (exitCode == 0 && exitStatus == QProcess::NormalExit) {
-            compilerOutput->append("Compilation successful!\nRunning program...\n");
-            runCompiledProgram();
+            compilerOutput->appendOutput(QString("Built in %1 ms").arg(buildTimer.elapsed()));
+            if (runMode == RunJudge) {
+                compilerOutput->appendOutput("Compilation successful!\n");
+                runJudge();
+            } else if (runMode == RunBenchmark) {
+                compilerOutput->appendOutput(QString("Compilation successful!\nBenchmarking %1...\n")
+                                             .arg(benchmarkExpression));
+                process->start(buildOutput, QStringList());
+            } else {
+                compilerOutput->appendOutput("Compilation successful!\nRunning program...\n");
+                runCompiledProgram();
+            }
         } else {
-            compilerOutput->append("Compilation failed!");
+            compilerOutput->appendOutput("Compilation failed!");
         }
     }
 }
@@ -405,6 +955,9 @@ void MainWindow::processError(QProcess::ProcessError error)
     switch (error) {
         case QProcess::FailedToStart:
             errorString = "Failed to start";
+            // No finished() follows, so the build would otherwise stay stuck
+            isCompiling = false;
+            buildingHeader = false;
             break;
         case QProcess::Crashed:
             errorString = "Process crashed";
@@ -412,17 +965,17 @@ void MainWindow::processError(QProcess::ProcessError error)
         default:
             errorString = "Unknown error";
     }
-    compilerOutput->append("Error: " + errorString);
+    compilerOutput->appendOutput("Error: " + errorString);
 }
 
 void MainWindow::readCompilerOutput()
 {
     if (isCompiling) {
-        compilerOutput->append(QString::fromLocal8Bit(process->readAllStandardError()));
+        compilerOutput->appendOutput(QString::fromLocal8Bit(process->readAllStandardError()));
     } else {
         QString output = QString::fromLocal8Bit(process->readAllStandardOutput());
         QString error = QString::fromLocal8Bit(process->readAllStandardError());
-        if (!output.isEmpty()) compilerOutput->append(output);
-        if (!error.isEmpty()) compilerOutput->append(error);
+        if (!output.isEmpty()) compilerOutput->appendOutput(output);
+        if (!error.isEmpty()) compilerOutput->appendOutput(error);
     }
 }
@@ -0,0 +1,91 @@
+#include "outputcomparator.h"
+
+OutputComparator::OutputComparator(const QString &expectedPath)
+    : expected(expectedPath), position(0), length(0), held(-1),
+      actualStarted(false), actualSpace(false), expectedStarted(false), expectedSpace(false),
+      tokenIndex(1), mismatch(false)
+{
+    opened = expected.open(QIODevice::ReadOnly);
+}
+
+void OutputComparator::feed(const char *data, qint64 size)
+{
+    for (qint64 i = 0; i < size && !mismatch; ++i) {
+        const char c = data[i];
+        if (isSpace(c)) {
+            actualSpace = actualStarted;
+            continue;
+        }
+        if (actualSpace) {
+            actualSpace = false;
+            ++tokenIndex;
+            match(' ');
+        }
+        actualStarted = true;
+        match(c);
+    }
+}
+
+// Trailing whitespace is insignificant, so both sides must simply be exhausted
+void OutputComparator::finish()
+{
+    if (mismatch) return;
+    int next = nextExpected();
+    if (next == -1) return;
+
+    mismatch = true;
+    // A missing token after the last one printed, or the rest of a token cut short
+    if (next == ' ') {
+        ++tokenIndex;
+    }
+}
+
+bool OutputComparator::isSpace(char c)
+{
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\f' || c == '\v';
+}
+
+void OutputComparator::match(char c)
+{
+    if (nextExpected() != static_cast<unsigned char>(c)) {
+        mismatch = true;
+    }
+}
+
+int OutputComparator::nextRaw()
+{
+    if (position == length) {
+        length = expected.read(buffer, sizeof(buffer));
+        position = 0;
+        if (length <= 0) {
+            length = 0;
+            return -1;
+        }
+    }
+    return static_cast<unsigned char>(buffer[position++]);
+}
+
+// Next byte of the expected output with whitespace runs collapsed to one space
+int OutputComparator::nextExpected()
+{
+    if (held >= 0) {
+        int c = held;
+        held = -1;
+        return c;
+    }
+    forever {
+        int c = nextRaw();
+        if (c < 0) return -1;
+        if (isSpace(char(c))) {
+            expectedSpace = expectedStarted;
+            continue;
+        }
+        expectedStarted = true;
+        if (expectedSpace) {
+            expectedSpace = false;
+            held = c;
+            return ' ';
+        }
+        return c;
+    }
+}
@@ -0,0 +1,56 @@
+#include "outputpane.h"
+
+OutputPane::OutputPane(QWidget *parent)
+    : QTextEdit(parent)
+{
+    setReadOnly(true);
+    setFont(QFont("Courier", 12));
+    setStyleSheet(
+        "QTextEdit {"
+        "  background: qlineargradient(x1:0, y1:0, x2:0, y2:1,"
+        "                             stop:0 #1a2634, stop:0.3 #2a3d50,"    // Deep ocean gradient
+        "                             stop:0.7 #3d4d5e, stop:1 #4a5d70);"   // Sandy ocean floor
+        "  background-image: repeating-linear-gradient("                     // Wave pattern
+        "    0deg,"
+        "    rgba(210, 180, 140, 0.02),"  // Lighter sandy waves
+        "    rgba(210, 180, 140, 0.02) 8px,"
+        "    transparent 8px,"
+        "    transparent 16px"
+        "  );"
+        "  color: #E2E8F0;"              // Soft white text
+        "  border: 1px solid #d2b48c;"    // Sandy border
+        "  border-radius: 4px;"
+        "  padding: 8px;"
+        "  selection-background-color: #4a5d70;"  // Ocean highlight
+        "}"
+    );
+
+    flushTimer = new QTimer(this);
+    flushTimer->setSingleShot(true);
+    flushTimer->setInterval(FLUSH_INTERVAL);
+    connect(flushTimer, &QTimer::timeout, this, &OutputPane::flush);
+}
+
+void OutputPane::appendOutput(const QString &text)
+{
+    // Each call becomes its own paragraph, as with QTextEdit::append()
+    pending.append(text);
+    if (!flushTimer->isActive()) {
+        flushTimer->start();
+    }
+}
+
+void OutputPane::clearOutput()
+{
+    flushTimer->stop();
+    pending.clear();
+    clear();
+}
+
+void OutputPane::flush()
+{
+    flushTimer->stop();
+    if (pending.isEmpty()) return;
+    append(pending.join('\n'));
+    pending.clear();
+}
@@ -0,0 +1,173 @@
+#include "precompiledheader.h"
+#include "sourcefile.h"
+#include <QCryptographicHash>
+#include <QStandardPaths>
+#include <QFileInfo>
+#include <QFile>
+#include <QDir>
+#include <QPair>
+#include <QDebug>
+#include <algorithm>
+
+PrecompiledHeader::PrecompiledHeader()
+{
+}
+
+PrecompiledHeader::PrecompiledHeader(const QString &compiler, const QStringList &flags, const QString &includeBlock)
+    : compilerProgram(compiler), buildFlags(flags), block(includeBlock)
+{
+    if (block.isEmpty()) return;
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(compiler.toUtf8());
+    hash.addData("\n");
+    hash.addData(flags.join('\n').toUtf8());
+    hash.addData("\n");
+    hash.addData(block.toUtf8());
+    directory = cacheRoot() + "/" + QString::fromLatin1(hash.result().toHex().left(16));
+}
+
+QString PrecompiledHeader::includeBlock(const QString &source)
+{
+    // Quoted includes are project headers that can change without this block
+    // changing, and any other directive may alter how the headers parse
+    QStringList includes;
+    bool inComment = false;
+    for (const QString &rawLine : source.split('\n')) {
+        QString line = rawLine.trimmed();
+        if (inComment) {
+            int end = line.indexOf("*/");
+            if (end < 0) continue;
+            inComment = false;
+            line = line.mid(end + 2).trimmed();
+        }
+        if (line.startsWith("/*")) {
+            int end = line.indexOf("*/", 2);
+            if (end < 0) {
+                inComment = true;
+                continue;
+            }
+            line = line.mid(end + 2).trimmed();
+        }
+        if (line.isEmpty() || line.startsWith("//")) continue;
+
+        if (!line.startsWith('#')) break;
+        QString directive = line.mid(1).trimmed();
+        if (!directive.startsWith("include")) break;
+        QString target = directive.mid(7).trimmed();
+        if (!target.startsWith('<')) break;
+        int close = target.indexOf('>');
+        if (close < 0) break;
+        includes.append("#include " + target.left(close + 1));
+    }
+    return includes.isEmpty() ? QString() : includes.join('\n') + '\n';
+}
+
+bool PrecompiledHeader::isNull() const
+{
+    return directory.isEmpty();
+}
+
+bool PrecompiledHeader::isUpToDate() const
+{
+    return !isNull() && QFileInfo::exists(binaryPath()) && QFileInfo::exists(headerPath());
+}
+
+bool PrecompiledHeader::hasFailed() const
+{
+    return !isNull() && QFileInfo::exists(failedPath());
+}
+
+void PrecompiledHeader::markFailed() const
+{
+    QFile file(failedPath());
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qDebug() << "Cannot record failed precompiled header:" << file.errorString();
+    }
+}
+
+void PrecompiledHeader::markUsed() const
+{
+    // The header itself is left alone: clang rejects a .pch whose input changed after it was built
+    QFile file(binaryPath());
+    if (file.open(QIODevice::ReadOnly)) {
+        file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+    }
+}
+
+bool PrecompiledHeader::prepare(QString *errorString) const
+{
+    if (!QDir().mkpath(directory)) {
+        if (errorString) *errorString = QString("Cannot create %1").arg(directory);
+        return false;
+    }
+    // Written before pruning so the new entry counts as the most recently used
+    if (!SourceFile::write(headerPath(), block, errorString)) return false;
+    prune();
+    return true;
+}
+
+QStringList PrecompiledHeader::buildArguments() const
+{
+    // Built under a temporary name so an interrupted build never leaves a truncated header behind
+    QStringList arguments = buildFlags;
+    arguments << "-x" << "c++-header" << headerPath() << "-o" << binaryPath() + ".tmp";
+    return arguments;
+}
+
+bool PrecompiledHeader::commit() const
+{
+    QFile::remove(binaryPath());
+    return QFile::rename(binaryPath() + ".tmp", binaryPath());
+}
+
+QStringList PrecompiledHeader::compileArguments() const
+{
+    // -Winvalid-pch reports a header the compiler refuses instead of silently parsing from source
+    return QStringList() << "-include" << headerPath() << "-Winvalid-pch";
+}
+
+QString PrecompiledHeader::headerPath() const
+{
+    return directory + "/stable.h";
+}
+
+QString PrecompiledHeader::binaryPath() const
+{
+    // Clang looks for <header>.pch next to an -include'd header, GCC for <header>.gch
+    bool clang = QFileInfo(compilerProgram).fileName().contains("clang");
+    return headerPath() + (clang ? ".pch" : ".gch");
+}
+
+QString PrecompiledHeader::failedPath() const
+{
+    return directory + "/failed";
+}
+
+QString PrecompiledHeader::cacheRoot()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation) + "/beach-ide/pch";
+}
+
+QDateTime PrecompiledHeader::lastUsed(const QString &entry)
+{
+    // The newest file of an entry: its header, the built binary (touched on every hit) or the failure marker
+    QFileInfoList files = QDir(entry).entryInfoList(QDir::Files, QDir::Time);
+    return files.isEmpty() ? QFileInfo(entry).lastModified() : files.first().lastModified();
+}
+
+void PrecompiledHeader::prune()
+{
+    QDir root(cacheRoot());
+    QList<QPair<QDateTime, QString>> entries;
+    for (const QFileInfo &info : root.entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot)) {
+        entries.append(qMakePair(lastUsed(info.absoluteFilePath()), info.absoluteFilePath()));
+    }
+    std::sort(entries.begin(), entries.end(), [](const QPair<QDateTime, QString> &a, const QPair<QDateTime, QString> &b) {
+        return a.first > b.first;
+    });
+    for (int i = MAX_CACHED; i < entries.size(); ++i) {
+        qDebug() << "Removing stale precompiled header" << QFileInfo(entries[i].second).fileName();
+        QDir(entries[i].second).removeRecursively();
+    }
+}
@@ -0,0 +1,409 @@
+#include "projectreplace.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QTextCodec>
+#include <QTextCursor>
+#include <QThread>
+#include <cstring>
+
+QRegularExpression ReplaceOptions::expression() const
+{
+    QString source = regex ? pattern : QRegularExpression::escape(pattern);
+    if (wholeWord) {
+        source = "\\b(?:" + source + ")\\b";
+    }
+    QRegularExpression::PatternOptions flags = QRegularExpression::NoPatternOption;
+    if (!caseSensitive) {
+        flags |= QRegularExpression::CaseInsensitiveOption;
+    }
+    return QRegularExpression(source, flags);
+}
+
+QString ReplaceOptions::substitute(const QRegularExpressionMatch &match) const
+{
+    if (!regex) return replacement;
+
+    QString result;
+    for (int i = 0; i < replacement.size(); ++i) {
+        const QChar c = replacement.at(i);
+        if (c == QLatin1Char('\\') && i + 1 < replacement.size()) {
+            const QChar next = replacement.at(++i);
+            if (next.isDigit()) result += match.captured(next.digitValue());
+            else if (next == QLatin1Char('n')) result += QLatin1Char('\n');
+            else if (next == QLatin1Char('t')) result += QLatin1Char('\t');
+            else result += next;
+        } else {
+            result += c;
+        }
+    }
+    return result;
+}
+
+// Contents of a file, memory-mapped when possible. The bytes are only valid
+// while the reader is alive.
+class MappedFile
+{
+public:
+    explicit MappedFile(const QString &path) : file(path) {}
+
+    bool open(QString *error)
+    {
+        if (!file.open(QIODevice::ReadOnly)) {
+            *error = file.errorString();
+            return false;
+        }
+        const qint64 size = file.size();
+        if (size > qint64(ProjectReplace::MAX_FILE_MB) * 1024 * 1024) {
+            *error = "File too large";
+            return false;
+        }
+        if (size == 0) return true;
+
+        uchar *data = file.map(0, size);
+        if (data) {
+            bytes = QByteArray::fromRawData(reinterpret_cast<const char *>(data), int(size));
+        } else {
+            bytes = file.readAll();
+        }
+        return true;
+    }
+
+    // A NUL byte near the start marks a binary file
+    bool isBinary() const
+    {
+        return std::memchr(bytes.constData(), 0, size_t(qMin(bytes.size(), 8192))) != nullptr;
+    }
+
+    bool hasBom() const
+    {
+        return bytes.startsWith("\xEF\xBB\xBF");
+    }
+
+    // False if the bytes are not valid UTF-8, so the text could not be written back unchanged.
+    // A byte order mark is dropped; see hasBom().
+    bool decode(QString *text) const
+    {
+        QTextCodec::ConverterState state;
+        *text = QTextCodec::codecForName("UTF-8")->toUnicode(bytes.constData(), bytes.size(), &state);
+        return state.invalidChars == 0;
+    }
+
+    QFile file;
+    QByteArray bytes;
+};
+
+ProjectReplace::ProjectReplace(QObject *parent)
+    : QObject(parent), cancelled(std::make_shared<std::atomic_bool>(false)),
+      searching(false), listedFiles(-1), searchedFiles(0), matchedFiles(0), totalMatches(0),
+      applyTotal(0), applyDone(0), applyReplacements(0), applyFailures(0)
+{
+    qRegisterMetaType<FileMatches>();
+    searchPool = new QThreadPool(this);
+    searchPool->setMaxThreadCount(QThread::idealThreadCount());
+    writePool = new QThreadPool(this);
+    writePool->setMaxThreadCount(qMin(QThread::idealThreadCount(), int(MAX_PARALLEL_WRITES)));
+}
+
+ProjectReplace::~ProjectReplace()
+{
+    cancel();
+    searchPool->waitForDone();
+    writePool->waitForDone();
+}
+
+void ProjectReplace::cancel()
+{
+    cancelled->store(true);
+    searching = false;
+}
+
+void ProjectReplace::search(const QString &root, const ReplaceOptions &options)
+{
+    // A fresh flag, so results of an earlier search are recognized and dropped
+    cancel();
+    cancelled = std::make_shared<std::atomic_bool>(false);
+    searching = true;
+    listedFiles = -1;
+    searchedFiles = 0;
+    matchedFiles = 0;
+    totalMatches = 0;
+
+    if (options.pattern.isEmpty() || !options.expression().isValid()) {
+        searching = false;
+        emit searchFinished(0, 0);
+        return;
+    }
+
+    std::shared_ptr<std::atomic_bool> flag = cancelled;
+    searchPool->start([this, root, options, flag]() {
+        listFiles(root, options, flag);
+    });
+}
+
+void ProjectReplace::listFiles(const QString &root, const ReplaceOptions &options,
+                               const std::shared_ptr<std::atomic_bool> &flag)
+{
+    int files = 0;
+    QStringList batch;
+    auto queueBatch = [this, &batch, &options, &flag]() {
+        QStringList paths = batch;
+        batch.clear();
+        std::shared_ptr<std::atomic_bool> taskFlag = flag;
+        searchPool->start([this, paths, options, taskFlag]() {
+            QList<FileMatches> results = searchBatch(paths, options, *taskFlag);
+            QMetaObject::invokeMethod(this, [this, paths, results, taskFlag]() {
+                if (taskFlag == cancelled) batchSearched(paths.size(), results);
+            }, Qt::QueuedConnection);
+        });
+    };
+
+    // Hidden directories and build output are not part of the project's sources
+    QStringList directories{root};
+    while (!directories.isEmpty() && !flag->load()) {
+        QDir dir(directories.takeLast());
+        const QFileInfoList entries = dir.entryInfoList(QDir::Dirs | QDir::Files | QDir::NoDotAndDotDot,
+                                                        QDir::Name);
+        for (const QFileInfo &entry : entries) {
+            if (entry.isDir()) {
+                if (!entry.isSymLink() && !entry.fileName().startsWith('.') && entry.fileName() != "build") {
+                    directories.append(entry.filePath());
+                }
+            } else if (!entry.fileName().startsWith('.')) {
+                batch.append(entry.filePath());
+                ++files;
+                if (batch.size() == BATCH_FILES) queueBatch();
+            }
+        }
+    }
+    if (!batch.isEmpty()) queueBatch();
+
+    QMetaObject::invokeMethod(this, [this, files, flag]() {
+        if (flag == cancelled) listingFinished(files);
+    }, Qt::QueuedConnection);
+}
+
+QList<FileMatches> ProjectReplace::searchBatch(const QStringList &paths, const ReplaceOptions &options,
+                                               const std::atomic_bool &cancelled)
+{
+    // One compiled expression per batch; instances are not shared across threads
+    const QRegularExpression expression = options.expression();
+    QList<FileMatches> results;
+    for (const QString &path : paths) {
+        if (cancelled.load()) break;
+        FileMatches result;
+        if (searchFile(path, options, expression, &result)) {
+            results.append(result);
+        }
+    }
+    return results;
+}
+
+bool ProjectReplace::searchFile(const QString &path, const ReplaceOptions &options,
+                                const QRegularExpression &expression, FileMatches *result)
+{
+    MappedFile mapped(path);
+    QString error;
+    if (!mapped.open(&error) || mapped.bytes.isEmpty() || mapped.isBinary()) return false;
+
+    // Most files do not match; reject them on the raw bytes before decoding
+    if (options.literalBytes() && mapped.bytes.indexOf(options.pattern.toUtf8()) < 0) return false;
+
+    QString text;
+    if (!mapped.decode(&text)) return false;
+
+    result->path = path;
+    int line = 1;
+    int counted = 0;  // Newlines are counted up to here
+    QRegularExpressionMatchIterator it = expression.globalMatch(text);
+    while (it.hasNext()) {
+        QRegularExpressionMatch match = it.next();
+        if (match.capturedLength() == 0) continue;
+        ++result->count;
+        if (result->matches.size() >= MAX_PREVIEW_MATCHES) continue;
+
+        const int start = match.capturedStart();
+        for (; counted < start; ++counted) {
+            if (text.at(counted) == QLatin1Char('\n')) ++line;
+        }
+        const int lineStart = text.lastIndexOf(QLatin1Char('\n'), start - 1) + 1;
+        int lineEnd = text.indexOf(QLatin1Char('\n'), start);
+        if (lineEnd < 0) lineEnd = text.size();
+
+        ReplaceMatch preview;
+        preview.line = line;
+        preview.column = start - lineStart;
+        preview.length = match.capturedLength();
+        preview.lineText = text.mid(lineStart, lineEnd - lineStart);
+        preview.replacedLine = preview.lineText;
+        preview.replacedLine.replace(preview.column, qMin(preview.length, lineEnd - start),
+                                     options.substitute(match));
+        result->matches.append(preview);
+    }
+    return result->count > 0;
+}
+
+void ProjectReplace::batchSearched(int files, const QList<FileMatches> &results)
+{
+    searchedFiles += files;
+    for (const FileMatches &file : results) {
+        ++matchedFiles;
+        totalMatches += file.count;
+        emit fileMatched(file);
+    }
+    finishSearchIfDone();
+}
+
+void ProjectReplace::listingFinished(int files)
+{
+    listedFiles = files;
+    finishSearchIfDone();
+}
+
+void ProjectReplace::finishSearchIfDone()
+{
+    if (!searching || listedFiles < 0 || searchedFiles < listedFiles) return;
+    searching = false;
+    emit searchFinished(matchedFiles, totalMatches);
+}
+
+void ProjectReplace::apply(const QStringList &paths, const ReplaceOptions &options)
+{
+    if (isApplying()) return;
+    applyTotal = paths.size();
+    applyDone = 0;
+    applyReplacements = 0;
+    applyFailures = 0;
+    if (applyTotal == 0) {
+        emit applyFinished(0, 0, 0);
+        return;
+    }
+
+    // Files are written with bounded concurrency so a large refactor does not flood the disk
+    cancel();
+    cancelled = std::make_shared<std::atomic_bool>(false);
+    for (const QString &path : paths) {
+        std::shared_ptr<std::atomic_bool> flag = cancelled;
+        writePool->start([this, path, options, flag]() {
+            QString error;
+            int count = 0;
+            if (flag->load()) {
+                error = "Cancelled";
+            } else {
+                count = replaceFile(path, options, &error);
+            }
+            QMetaObject::invokeMethod(this, [this, path, count, error]() {
+                fileApplied(path, count, error);
+            }, Qt::QueuedConnection);
+        });
+    }
+}
+
+int ProjectReplace::replaceFile(const QString &path, const ReplaceOptions &options, QString *error)
+{
+    MappedFile mapped(path);
+    if (!mapped.open(error)) return 0;
+    if (mapped.isBinary()) {
+        *error = "Binary file";
+        return 0;
+    }
+
+    QSaveFile out(path);
+    if (!out.open(QIODevice::WriteOnly)) {
+        *error = out.errorString();
+        return 0;
+    }
+
+    // Unchanged stretches are written straight from the map between replacements
+    int count = 0;
+    const QByteArray &bytes = mapped.bytes;
+    if (options.literalBytes()) {
+        const QByteArray needle = options.pattern.toUtf8();
+        const QByteArray with = options.replacement.toUtf8();
+        int from = 0;
+        for (int index = bytes.indexOf(needle); index >= 0; index = bytes.indexOf(needle, from)) {
+            out.write(bytes.constData() + from, index - from);
+            out.write(with);
+            from = index + needle.size();
+            ++count;
+        }
+        out.write(bytes.constData() + from, bytes.size() - from);
+    } else {
+        QString text;
+        if (!mapped.decode(&text)) {
+            *error = "Not valid UTF-8";
+            out.cancelWriting();
+            return 0;
+        }
+        // Decoding drops the byte order mark and toUtf8() never adds one
+        if (mapped.hasBom()) {
+            out.write("\xEF\xBB\xBF");
+        }
+        int from = 0;
+        QRegularExpressionMatchIterator it = options.expression().globalMatch(text);
+        while (it.hasNext()) {
+            QRegularExpressionMatch match = it.next();
+            if (match.capturedLength() == 0) continue;
+            out.write(text.midRef(from, match.capturedStart() - from).toUtf8());
+            out.write(options.substitute(match).toUtf8());
+            from = match.capturedEnd();
+            ++count;
+        }
+        out.write(text.midRef(from).toUtf8());
+    }
+
+    // The map must be released before the temporary file replaces it
+    mapped.bytes.clear();
+    mapped.file.close();
+    if (count == 0) {
+        out.cancelWriting();
+        return 0;
+    }
+    if (!out.commit()) {
+        *error = out.errorString();
+        return 0;
+    }
+    return count;
+}
+
+void ProjectReplace::fileApplied(const QString &path, int count, const QString &error)
+{
+    ++applyDone;
+    applyReplacements += count;
+    if (!error.isEmpty()) ++applyFailures;
+    emit fileReplaced(path, count, error);
+
+    if (applyDone == applyTotal) {
+        const int files = applyTotal - applyFailures;
+        applyTotal = 0;
+        emit applyFinished(files, applyReplacements, applyFailures);
+    }
+}
+
+int ProjectReplace::replaceInDocument(QTextDocument *document, const ReplaceOptions &options)
+{
+    const QRegularExpression expression = options.expression();
+    if (options.pattern.isEmpty() || !expression.isValid()) return 0;
+
+    struct Edit { int start; int length; QString text; };
+    QList<Edit> edits;
+    QRegularExpressionMatchIterator it = expression.globalMatch(document->toPlainText());
+    while (it.hasNext()) {
+        QRegularExpressionMatch match = it.next();
+        if (match.capturedLength() == 0) continue;
+        edits.append({match.capturedStart(), match.capturedLength(), options.substitute(match)});
+    }
+    if (edits.isEmpty()) return 0;
+
+    // Back to front, so earlier positions stay valid; one edit block is one undo step
+    QTextCursor cursor(document);
+    cursor.beginEditBlock();
+    for (int i = edits.size() - 1; i >= 0; --i) {
+        cursor.setPosition(edits.at(i).start);
+        cursor.setPosition(edits.at(i).start + edits.at(i).length, QTextCursor::KeepAnchor);
+        cursor.insertText(edits.at(i).text);
+    }
+    cursor.endEditBlock();
+    return edits.size();
+}
@@ -0,0 +1,213 @@
+#include "replacepanel.h"
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QFileInfo>
+#include <QDir>
+#include <QColor>
+#include <QDebug>
+
+ReplacePanel::ReplacePanel(QWidget *parent)
+    : QWidget(parent)
+{
+    engine = new ProjectReplace(this);
+    connect(engine, &ProjectReplace::fileMatched, this, &ReplacePanel::addFile);
+    connect(engine, &ProjectReplace::searchFinished, this, &ReplacePanel::searchFinished);
+    connect(engine, &ProjectReplace::applyFinished, this, &ReplacePanel::applyFinished);
+    connect(engine, &ProjectReplace::fileReplaced, this, &ReplacePanel::fileReplaced);
+
+    findEdit = new QLineEdit;
+    findEdit->setPlaceholderText("Find");
+    replaceEdit = new QLineEdit;
+    replaceEdit->setPlaceholderText("Replace with");
+    regexBox = new QCheckBox("Regex");
+    caseBox = new QCheckBox("Match case");
+    caseBox->setChecked(true);
+    wordBox = new QCheckBox("Whole word");
+    findButton = new QPushButton("Find");
+    replaceButton = new QPushButton("Replace All");
+    replaceButton->setEnabled(false);
+
+    results = new QTreeWidget;
+    results->setHeaderHidden(true);
+    results->setUniformRowHeights(true);
+    results->setFont(QFont("Courier", 11));
+    results->setStyleSheet(
+        "QTreeWidget {"
+        "  background-color: #1a2634;"  // Deep ocean
+        "  color: #E2E8F0;"            // Soft white text
+        "  border: 1px solid #d2b48c;"  // Sandy border
+        "  border-radius: 4px;"
+        "  selection-background-color: #4a5d70;"  // Ocean highlight
+        "}"
+    );
+    summary = new QLabel;
+
+    QHBoxLayout *options = new QHBoxLayout;
+    options->addWidget(regexBox);
+    options->addWidget(caseBox);
+    options->addWidget(wordBox);
+    options->addStretch();
+    options->addWidget(findButton);
+    options->addWidget(replaceButton);
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->setContentsMargins(4, 4, 4, 4);
+    layout->addWidget(findEdit);
+    layout->addWidget(replaceEdit);
+    layout->addLayout(options);
+    layout->addWidget(results);
+    layout->addWidget(summary);
+
+    connect(findEdit, &QLineEdit::returnPressed, this, &ReplacePanel::startSearch);
+    connect(findButton, &QPushButton::clicked, this, &ReplacePanel::startSearch);
+    connect(replaceButton, &QPushButton::clicked, this, &ReplacePanel::replaceAll);
+    connect(results, &QTreeWidget::itemActivated, this, &ReplacePanel::itemActivated);
+}
+
+void ReplacePanel::setRoot(const QString &directory)
+{
+    root = directory;
+}
+
+void ReplacePanel::setOpenFile(const QString &path)
+{
+    openFile = path.isEmpty() ? QString() : QFileInfo(path).absoluteFilePath();
+}
+
+void ReplacePanel::focusSearch(const QString &text)
+{
+    if (!text.isEmpty() && !text.contains(QChar::ParagraphSeparator)) {
+        findEdit->setText(text);
+    }
+    findEdit->setFocus();
+    findEdit->selectAll();
+}
+
+ReplaceOptions ReplacePanel::currentOptions() const
+{
+    ReplaceOptions options;
+    options.pattern = findEdit->text();
+    options.replacement = replaceEdit->text();
+    options.regex = regexBox->isChecked();
+    options.caseSensitive = caseBox->isChecked();
+    options.wholeWord = wordBox->isChecked();
+    return options;
+}
+
+bool ReplacePanel::isOpenFile(const QString &path) const
+{
+    return !openFile.isEmpty() && QFileInfo(path).absoluteFilePath() == openFile;
+}
+
+void ReplacePanel::setBusy(bool busy)
+{
+    findButton->setEnabled(!engine->isApplying());
+    replaceButton->setEnabled(!busy && results->topLevelItemCount() > 0);
+}
+
+void ReplacePanel::startSearch()
+{
+    searched = currentOptions();
+    if (!searched.expression().isValid()) {
+        summary->setText("Invalid pattern: " + searched.expression().errorString());
+        return;
+    }
+    results->clear();
+    summary->setText("Searching " + QDir::toNativeSeparators(root) + "...");
+    setBusy(true);
+    engine->search(root, searched);
+}
+
+void ReplacePanel::addFile(const FileMatches &file)
+{
+    QTreeWidgetItem *fileItem = new QTreeWidgetItem(results);
+    fileItem->setText(0, QString("%1 (%2)").arg(QDir(root).relativeFilePath(file.path)).arg(file.count));
+    fileItem->setData(0, Qt::UserRole, file.path);
+    fileItem->setFlags(fileItem->flags() | Qt::ItemIsUserCheckable);
+    fileItem->setCheckState(0, Qt::Checked);
+
+    for (const ReplaceMatch &match : file.matches) {
+        QTreeWidgetItem *matchItem = new QTreeWidgetItem(fileItem);
+        matchItem->setText(0, QString("%1: %2").arg(match.line).arg(match.lineText.trimmed()));
+        matchItem->setToolTip(0, match.replacedLine.trimmed());
+        matchItem->setData(0, Qt::UserRole, file.path);
+        matchItem->setData(0, Qt::UserRole + 1, match.line);
+    }
+    if (file.count > file.matches.size()) {
+        new QTreeWidgetItem(fileItem, QStringList(QString("... %1 more").arg(file.count - file.matches.size())));
+    }
+}
+
+void ReplacePanel::searchFinished(int files, int matches)
+{
+    summary->setText(QString("%1 matches in %2 files").arg(matches).arg(files));
+    setBusy(false);
+}
+
+void ReplacePanel::replaceAll()
+{
+    // The replacement may be edited after the search; the pattern may not
+    ReplaceOptions options = searched;
+    options.replacement = replaceEdit->text();
+
+    QStringList paths;
+    for (int i = 0; i < results->topLevelItemCount(); ++i) {
+        QTreeWidgetItem *item = results->topLevelItem(i);
+        if (item->checkState(0) != Qt::Checked) continue;
+        const QString path = item->data(0, Qt::UserRole).toString();
+        if (isOpenFile(path)) {
+            emit replaceInOpenFile(options);
+        } else {
+            paths.append(path);
+        }
+    }
+    if (paths.isEmpty()) {
+        results->clear();
+        summary->clear();
+        setBusy(false);
+        return;
+    }
+
+    skipped.clear();
+    summary->setText(QString("Replacing in %1 files...").arg(paths.size()));
+    engine->apply(paths, options);
+    setBusy(true);
+}
+
+void ReplacePanel::fileReplaced(const QString &path, int count, const QString &error)
+{
+    Q_UNUSED(count);
+    if (!error.isEmpty()) {
+        qDebug() << "Replace failed in" << path << ":" << error;
+        skipped.append(qMakePair(path, error));
+    }
+}
+
+void ReplacePanel::applyFinished(int files, int replacements, int failures)
+{
+    QString message = QString("Replaced %1 matches in %2 files").arg(replacements).arg(files);
+    if (failures > 0) {
+        message += QString(", %1 skipped").arg(failures);
+    }
+
+    // Skipped files stay listed with the reason, so they can be opened and fixed by hand
+    results->clear();
+    for (const QPair<QString, QString> &file : qAsConst(skipped)) {
+        QTreeWidgetItem *item = new QTreeWidgetItem(results);
+        item->setText(0, QString("Skipped %1: %2").arg(QDir(root).relativeFilePath(file.first), file.second));
+        item->setForeground(0, QColor("#ef9a9a"));  // Coral warning
+        item->setData(0, Qt::UserRole, file.first);
+    }
+    skipped.clear();
+    summary->setText(message);
+    setBusy(false);
+    replaceButton->setEnabled(false);  // Nothing left to replace until the next search
+    emit statusChanged(message);
+}
+
+void ReplacePanel::itemActivated(QTreeWidgetItem *item)
+{
+    const QString path = item->data(0, Qt::UserRole).toString();
+    if (path.isEmpty()) return;
+    emit matchActivated(path, qMax(1, item->data(0, Qt::UserRole + 1).toInt()));
+}
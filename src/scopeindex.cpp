@@ -0,0 +1,263 @@
+#include "scopeindex.h"
+#include <QRegularExpression>
+
+ScopeIndex *ScopeIndex::of(QTextDocument *document)
+{
+    ScopeIndex *index = document->findChild<ScopeIndex *>(QString(), Qt::FindDirectChildrenOnly);
+    if (!index) {
+        index = new ScopeIndex(document);
+    }
+    return index;
+}
+
+ScopeBlockData *ScopeIndex::data(const QTextBlock &block)
+{
+    return static_cast<ScopeBlockData *>(block.userData());
+}
+
+ScopeIndex::ScopeIndex(QTextDocument *document)
+    : QObject(document), document(document)
+{
+    connect(document, &QTextDocument::contentsChange, this, &ScopeIndex::contentsChanged);
+    rescan(document->begin(), document->lastBlock());
+}
+
+QString ScopeIndex::declarationOf(const QString &text)
+{
+    static const QRegularExpression declarationPattern(QStringLiteral(
+        "^\\s*(#include\\b|#define\\b|using\\b|typedef\\b|template\\b"
+        "|(class|struct|enum|union|namespace)\\b"
+        "|[A-Za-z_][\\w:<>,\\*&\\s]*\\s[\\*&]*[A-Za-z_~][\\w:]*\\s*\\()"));
+    static const QRegularExpression statementPattern(
+        QStringLiteral("^\\s*(return|delete|throw|else|case|goto)\\b"));
+
+    if (!declarationPattern.match(text).hasMatch() || statementPattern.match(text).hasMatch()) {
+        return QString();
+    }
+    QString line = text.trimmed();
+    if (line.endsWith('{')) {
+        line.chop(1);
+        line = line.trimmed();
+    }
+    return line;
+}
+
+void ScopeIndex::scan(const QString &text, int depth, bool inComment, ScopeBlockData *data)
+{
+    data->depthBefore = depth;
+    data->commentBefore = inComment;
+    data->minDepth = depth;
+    data->brackets.clear();
+
+    // Only blocks starting at file or namespace level hold declarations worth quoting
+    data->declaration = depth <= 1 && !inComment ? declarationOf(text) : QString();
+    data->declarationTokens = -1;
+
+    bool inLiteral = false;
+    QChar quote;
+    for (int i = 0; i < text.size(); ++i) {
+        const QChar c = text.at(i);
+        if (inComment) {
+            if (c == QLatin1Char('*') && i + 1 < text.size() && text.at(i + 1) == QLatin1Char('/')) {
+                inComment = false;
+                ++i;
+            }
+        } else if (inLiteral) {
+            if (c == QLatin1Char('\\')) ++i;
+            else if (c == quote) inLiteral = false;
+        } else if (c == QLatin1Char('"')
+                   || (c == QLatin1Char('\'') && !(i > 0 && text.at(i - 1).isDigit()))) {
+            // A quote after a digit is a C++14 digit separator
+            inLiteral = true;
+            quote = c;
+        } else if (c == QLatin1Char('/') && i + 1 < text.size()) {
+            if (text.at(i + 1) == QLatin1Char('/')) break;
+            if (text.at(i + 1) == QLatin1Char('*')) {
+                inComment = true;
+                ++i;
+            }
+        } else if (c == QLatin1Char('{')) {
+            data->brackets.append({c, i, depth});
+            ++depth;
+        } else if (c == QLatin1Char('}')) {
+            depth = qMax(0, depth - 1);
+            data->brackets.append({c, i, depth});
+            data->minDepth = qMin(data->minDepth, depth);
+        } else if (c == QLatin1Char('(') || c == QLatin1Char(')')
+                   || c == QLatin1Char('[') || c == QLatin1Char(']')) {
+            data->brackets.append({c, i, 0});
+        }
+    }
+    data->depthAfter = depth;
+    data->commentAfter = inComment;
+
+    // The outermost '{' that no later '}' in this block closes starts a foldable scope
+    data->openDepth = -1;
+    int low = depth;
+    for (int i = data->brackets.size() - 1; i >= 0; --i) {
+        const ScopeBlockData::Bracket &bracket = data->brackets.at(i);
+        if (bracket.character == QLatin1Char('}')) {
+            low = qMin(low, bracket.depth);
+        } else if (bracket.character == QLatin1Char('{') && bracket.depth < low) {
+            data->openDepth = bracket.depth;
+            low = bracket.depth;
+        }
+    }
+}
+
+void ScopeIndex::rescan(QTextBlock block, const QTextBlock &to)
+{
+    int depth = 0;
+    bool inComment = false;
+    ScopeBlockData *previous = data(block.previous());
+    if (previous) {
+        depth = previous->depthAfter;
+        inComment = previous->commentAfter;
+    }
+
+    int first = block.blockNumber();
+    int last = first;
+    bool pastEdit = false;
+    while (block.isValid()) {
+        ScopeBlockData *blockData = data(block);
+        // Past the edited range, stop as soon as the carried state is what the block already saw
+        if (pastEdit && blockData && blockData->depthBefore == depth && blockData->commentBefore == inComment) {
+            break;
+        }
+        if (!blockData) {
+            blockData = new ScopeBlockData;
+            block.setUserData(blockData);
+        }
+        scan(block.text(), depth, inComment, blockData);
+        depth = blockData->depthAfter;
+        inComment = blockData->commentAfter;
+        last = block.blockNumber();
+
+        if (block == to) pastEdit = true;
+        block = block.next();
+    }
+    emit structureChanged(first, last);
+}
+
+void ScopeIndex::contentsChanged(int position, int charsRemoved, int charsAdded)
+{
+    Q_UNUSED(charsRemoved);
+    QTextBlock from = document->findBlock(position);
+    QTextBlock to = document->findBlock(position + charsAdded);
+    if (!from.isValid()) from = document->begin();
+    if (!to.isValid()) to = document->lastBlock();
+    rescan(from, to);
+}
+
+int ScopeIndex::matchingBracket(int position) const
+{
+    QTextBlock block = document->findBlock(position);
+    ScopeBlockData *blockData = data(block);
+    if (!blockData) return -1;
+
+    int offset = position - block.position();
+    int index = -1;
+    for (int i = 0; i < blockData->brackets.size(); ++i) {
+        if (blockData->brackets.at(i).position == offset) {
+            index = i;
+            break;
+        }
+    }
+    if (index < 0) return -1;
+
+    const ScopeBlockData::Bracket bracket = blockData->brackets.at(index);
+    const QChar c = bracket.character;
+    const bool forward = c == QLatin1Char('{') || c == QLatin1Char('(') || c == QLatin1Char('[');
+    QChar partner;
+    if (c == QLatin1Char('{')) partner = QLatin1Char('}');
+    else if (c == QLatin1Char('}')) partner = QLatin1Char('{');
+    else if (c == QLatin1Char('(')) partner = QLatin1Char(')');
+    else if (c == QLatin1Char(')')) partner = QLatin1Char('(');
+    else if (c == QLatin1Char('[')) partner = QLatin1Char(']');
+    else partner = QLatin1Char('[');
+    const bool brace = c == QLatin1Char('{') || c == QLatin1Char('}');
+
+    // Braces pair up by depth and skip whole blocks that never reach it;
+    // other brackets are counted, within a bounded number of blocks
+    int nesting = 0;
+    for (int scanned = 0; ; ++scanned) {
+        const QVector<ScopeBlockData::Bracket> &brackets = blockData->brackets;
+        int step = forward ? 1 : -1;
+        for (int i = index + step; i >= 0 && i < brackets.size(); i += step) {
+            const ScopeBlockData::Bracket &candidate = brackets.at(i);
+            if (brace) {
+                if (candidate.character == partner && candidate.depth == bracket.depth) {
+                    return block.position() + candidate.position;
+                }
+            } else if (candidate.character == c) {
+                ++nesting;
+            } else if (candidate.character == partner) {
+                if (nesting == 0) return block.position() + candidate.position;
+                --nesting;
+            }
+        }
+
+        if (!brace && scanned >= MAX_BRACKET_SCAN_BLOCKS) return -1;
+        do {
+            block = forward ? block.next() : block.previous();
+            if (!block.isValid()) return -1;
+            blockData = data(block);
+        } while (!blockData || (brace && blockData->minDepth > bracket.depth));
+        index = forward ? -1 : blockData->brackets.size();
+    }
+}
+
+int ScopeIndex::scopeStart(int position) const
+{
+    QTextBlock block = document->findBlock(position);
+    ScopeBlockData *blockData = data(block);
+    if (!blockData) return -1;
+
+    // Brace depth at the position, and the last bracket before it
+    int offset = position - block.position();
+    int depth = blockData->depthBefore;
+    int index = -1;
+    for (int i = 0; i < blockData->brackets.size(); ++i) {
+        const ScopeBlockData::Bracket &bracket = blockData->brackets.at(i);
+        if (bracket.position >= offset) break;
+        if (bracket.character == QLatin1Char('{')) depth = bracket.depth + 1;
+        else if (bracket.character == QLatin1Char('}')) depth = bracket.depth;
+        index = i;
+    }
+    if (depth == 0) return -1;
+
+    // The opener is the last '{' before the position that was entered from one level out
+    const int target = depth - 1;
+    for (;;) {
+        for (int i = index; i >= 0; --i) {
+            const ScopeBlockData::Bracket &bracket = blockData->brackets.at(i);
+            if (bracket.character == QLatin1Char('{') && bracket.depth == target) {
+                return block.position() + bracket.position;
+            }
+        }
+        do {
+            block = block.previous();
+            if (!block.isValid()) return -1;
+            blockData = data(block);
+        } while (!blockData || blockData->minDepth > target);
+        index = blockData->brackets.size() - 1;
+    }
+}
+
+QTextBlock ScopeIndex::scopeEnd(const QTextBlock &block) const
+{
+    ScopeBlockData *blockData = data(block);
+    if (!blockData || blockData->openDepth < 0) return QTextBlock();
+
+    for (QTextBlock next = block.next(); next.isValid(); next = next.next()) {
+        ScopeBlockData *nextData = data(next);
+        if (nextData && nextData->minDepth <= blockData->openDepth) return next;
+    }
+    return QTextBlock();
+}
+
+bool ScopeIndex::opensScope(const QTextBlock &block) const
+{
+    ScopeBlockData *blockData = data(block);
+    return blockData && blockData->openDepth >= 0;
+}
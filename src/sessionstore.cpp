@@ -0,0 +1,139 @@
+#include "sessionstore.h"
+#include <QStandardPaths>
+#include <QCryptographicHash>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QDataStream>
+#include <QDateTime>
+#include <QSaveFile>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QPair>
+#include <QDebug>
+
+QString SessionStore::dataRoot()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation) + "/beach-ide";
+}
+
+Session SessionStore::load()
+{
+    Session session;
+    QFile file(dataRoot() + "/session.json");
+    if (!file.open(QIODevice::ReadOnly)) return session;
+
+    QJsonObject json = QJsonDocument::fromJson(file.readAll()).object();
+    session.file = json["file"].toString();
+    session.cursorPosition = json["cursor"].toInt();
+    session.scrollValue = json["scroll"].toInt();
+    session.firstVisibleBlock = json["firstVisibleBlock"].toInt();
+    session.lastVisibleBlock = json["lastVisibleBlock"].toInt(-1);
+    return session;
+}
+
+void SessionStore::save(const Session &session)
+{
+    QJsonObject json;
+    json["file"] = session.file;
+    json["cursor"] = session.cursorPosition;
+    json["scroll"] = session.scrollValue;
+    json["firstVisibleBlock"] = session.firstVisibleBlock;
+    json["lastVisibleBlock"] = session.lastVisibleBlock;
+
+    QDir().mkpath(dataRoot());
+    QSaveFile file(dataRoot() + "/session.json");
+    if (file.open(QIODevice::WriteOnly)) {
+        file.write(QJsonDocument(json).toJson());
+        if (file.commit()) return;
+    }
+    qDebug() << "Cannot save session:" << file.errorString();
+}
+
+QByteArray SessionStore::contentHash(const QString &text)
+{
+    // The UTF-16 data is hashed in place rather than encoded first
+    QByteArray raw = QByteArray::fromRawData(reinterpret_cast<const char *>(text.constData()),
+                                             text.size() * int(sizeof(QChar)));
+    return QCryptographicHash::hash(raw, QCryptographicHash::Sha1).toHex();
+}
+
+QString SessionStore::statesPath(const QByteArray &hash)
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation)
+           + "/beach-ide/highlight/" + QString::fromLatin1(hash) + ".states";
+}
+
+bool SessionStore::loadHighlightStates(const QByteArray &hash, int expectedBlocks, QVector<int> *states)
+{
+    QFile file(statesPath(hash));
+    if (!file.open(QIODevice::ReadOnly)) return false;
+    QByteArray data = qUncompress(file.readAll());
+
+    // Runs of equal states, which is what a highlighter's states mostly are
+    QDataStream in(data);
+    qint32 format = 0;
+    qint32 blocks = 0;
+    qint32 runs = 0;
+    in >> format >> blocks >> runs;
+    // The counts are checked before anything is allocated for them, as the file may be corrupt
+    if (in.status() != QDataStream::Ok || format != STATES_FORMAT || blocks != expectedBlocks
+        || runs < 0 || runs > blocks) {
+        return false;
+    }
+
+    states->clear();
+    states->reserve(blocks);
+    for (qint32 i = 0; i < runs; ++i) {
+        qint32 state = 0;
+        qint32 length = 0;
+        in >> state >> length;
+        if (in.status() != QDataStream::Ok || length < 0 || states->size() + length > blocks) return false;
+        states->insert(states->size(), length, state);
+    }
+    if (states->size() != blocks) return false;
+
+    // Recently used entries survive pruning; a read-only cache still restores
+    file.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+    return true;
+}
+
+void SessionStore::saveHighlightStates(const QByteArray &hash, const QVector<int> &states)
+{
+    QVector<QPair<qint32, qint32>> runs;  // State, length
+    for (int state : states) {
+        if (!runs.isEmpty() && runs.last().first == state) {
+            ++runs.last().second;
+        } else {
+            runs.append({state, 1});
+        }
+    }
+
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    out << qint32(STATES_FORMAT) << qint32(states.size()) << qint32(runs.size());
+    for (const QPair<qint32, qint32> &run : runs) {
+        out << run.first << run.second;
+    }
+
+    const QString path = statesPath(hash);
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile file(path);
+    if (file.open(QIODevice::WriteOnly)) {
+        file.write(qCompress(data));
+        if (file.commit()) {
+            prune();
+            return;
+        }
+    }
+    qDebug() << "Cannot cache highlight states:" << file.errorString();
+}
+
+void SessionStore::prune()
+{
+    QDir root(QFileInfo(statesPath(QByteArray())).absolutePath());
+    QFileInfoList entries = root.entryInfoList(QStringList{"*.states"}, QDir::Files, QDir::Time);
+    for (int i = MAX_CACHED_STATES; i < entries.size(); ++i) {
+        QFile::remove(entries[i].absoluteFilePath());
+    }
+}
@@ -0,0 +1,188 @@
+#include "settings.h"
+#include "completionclient.h"
+#include "contextbuilder.h"
+#include "completionwidget.h"
+#include "judgerunner.h"
+#include "undohistory.h"
+#include <QCoreApplication>
+#include <QMutexLocker>
+#include <QHash>
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QProcess>
+#include <QDir>
+#include <QDebug>
+
+static QString unquote(const QString &value)
+{
+    if (value.length() >= 2
+        && ((value.startsWith('"') && value.endsWith('"'))
+            || (value.startsWith('\'') && value.endsWith('\'')))) {
+        return value.mid(1, value.length() - 2);
+    }
+    return value;
+}
+
+static int intValue(const QHash<QString, QString> &values, const QString &key, int fallback)
+{
+    bool ok = false;
+    int value = values.value(key).toInt(&ok);
+    return ok ? value : fallback;
+}
+
+BuildProfile SettingsSnapshot::buildProfile(const QString &name) const
+{
+    for (const BuildProfile &profile : buildProfiles) {
+        if (profile.name == name) return profile;
+    }
+    return buildProfiles.value(0);
+}
+
+Settings *Settings::instance()
+{
+    static Settings *settings = new Settings(QCoreApplication::instance());
+    return settings;
+}
+
+Settings::Settings(QObject *parent)
+    : QObject(parent), envPath(QDir::currentPath() + "/.env")
+{
+    envContents = readEnv(envPath);
+    current = SettingsPtr(new SettingsSnapshot(parse(envContents)));
+
+    // Watch the directory as well so a .env that is created or replaced by rename is noticed
+    watcher = new QFileSystemWatcher(this);
+    watcher->addPath(QDir::currentPath());
+    if (QFileInfo::exists(envPath)) {
+        watcher->addPath(envPath);
+    }
+    connect(watcher, &QFileSystemWatcher::fileChanged, this, &Settings::scheduleReload);
+    connect(watcher, &QFileSystemWatcher::directoryChanged, this, &Settings::directoryChanged);
+
+    reloadTimer = new QTimer(this);
+    reloadTimer->setSingleShot(true);
+    reloadTimer->setInterval(RELOAD_DELAY);
+    connect(reloadTimer, &QTimer::timeout, this, &Settings::reload);
+}
+
+SettingsPtr Settings::snapshot() const
+{
+    QMutexLocker locker(&mutex);
+    return current;
+}
+
+QString Settings::path() const
+{
+    return envPath;
+}
+
+void Settings::scheduleReload()
+{
+    reloadTimer->start();
+}
+
+void Settings::directoryChanged()
+{
+    // Only .env appearing matters, whether created or replaced by an editor that
+    // saves by rename (which also drops it from the watch list)
+    if (QFileInfo::exists(envPath) && !watcher->files().contains(envPath)) {
+        watcher->addPath(envPath);
+        scheduleReload();
+    }
+}
+
+void Settings::reload()
+{
+    if (QFileInfo::exists(envPath) && !watcher->files().contains(envPath)) {
+        watcher->addPath(envPath);
+    }
+
+    // Touching or rewriting the file unchanged must not reconfigure everything
+    QByteArray contents = readEnv(envPath);
+    if (contents == envContents) return;
+    envContents = contents;
+
+    SettingsPtr updated(new SettingsSnapshot(parse(envContents)));
+    {
+        QMutexLocker locker(&mutex);
+        current = updated;
+    }
+
+    qDebug() << "Reloaded settings from" << envPath;
+    emit changed();
+}
+
+QByteArray Settings::readEnv(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        qDebug() << "Failed to open .env file:" << file.errorString();
+        return QByteArray();
+    }
+    return file.readAll();
+}
+
+SettingsSnapshot Settings::parse(const QByteArray &contents)
+{
+    QHash<QString, QString> values;
+    QList<BuildProfile> profiles;
+
+    QTextStream in(contents);
+    while (!in.atEnd()) {
+        QString line = in.readLine().trimmed();
+        if (line.isEmpty() || line.startsWith('#')) continue;
+        if (line.startsWith("export ")) {
+            line = line.mid(7).trimmed();
+        }
+        int equals = line.indexOf('=');
+        if (equals <= 0) continue;
+
+        QString key = line.left(equals).trimmed();
+        QString value = unquote(line.mid(equals + 1).trimmed());
+        if (key.startsWith("BUILD_PROFILE_")) {
+            // BUILD_PROFILE_<Name>="flags", in file order
+            profiles.append({key.mid(14), QProcess::splitCommand(value)});
+        } else {
+            values.insert(key, value);
+        }
+    }
+
+    SettingsSnapshot settings;
+    settings.apiKey = values.value("OPENAI_API_KEY");
+    settings.endpoint = QUrl(values.value("COMPLETION_ENDPOINT", CompletionClient::DEFAULT_ENDPOINT));
+    settings.alternateEndpoint = QUrl(values.value("COMPLETION_ALTERNATE_ENDPOINT"));
+
+    settings.models = values.value("COMPLETION_MODELS").split(',', Qt::SkipEmptyParts);
+    for (QString &model : settings.models) {
+        model = model.trimmed();
+    }
+    if (settings.models.isEmpty()) {
+        settings.models = QStringList{"gpt-4", "gpt-3.5-turbo"};
+    }
+
+    settings.tokenBudget = intValue(values, "COMPLETION_TOKEN_BUDGET", ContextBuilder::DEFAULT_TOKEN_BUDGET);
+    settings.deadlineMs = intValue(values, "COMPLETION_DEADLINE_MS", CompletionClient::DEFAULT_DEADLINE_MS);
+    settings.maxAttempts = intValue(values, "COMPLETION_MAX_ATTEMPTS", CompletionClient::DEFAULT_MAX_ATTEMPTS);
+    settings.hedging = intValue(values, "COMPLETION_HEDGING", 0) != 0;
+    settings.keepWarm = values.value("COMPLETION_KEEP_WARM", "startup").toLower();
+    settings.keepWarmIdleMs = intValue(values, "COMPLETION_KEEP_WARM_IDLE_MS", CompletionClient::DEFAULT_IDLE_MS);
+    settings.speculationBudget = intValue(values, "COMPLETION_SPECULATION_BUDGET", CompletionWidget::DEFAULT_SPECULATION_BUDGET);
+    settings.telemetry = values.value("COMPLETION_TELEMETRY", "metrics").toLower();
+    settings.telemetryDir = values.value("COMPLETION_TELEMETRY_DIR");
+    settings.compiler = values.value("COMPILER", "g++");
+
+    if (profiles.isEmpty()) {
+        profiles = {
+            {"Default", QStringList()},
+            {"Debug", QStringList{"-g", "-O0"}},
+            {"Release", QStringList{"-O2", "-DNDEBUG"}}
+        };
+    }
+    settings.buildProfiles = profiles;
+    settings.precompiledHeaders = intValue(values, "PRECOMPILED_HEADERS", 1) != 0;
+    settings.judgeTimeLimitMs = intValue(values, "JUDGE_TIME_LIMIT_MS", JudgeRunner::DEFAULT_TIME_LIMIT_MS);
+    settings.judgeMemoryLimitMb = intValue(values, "JUDGE_MEMORY_LIMIT_MB", JudgeRunner::DEFAULT_MEMORY_LIMIT_MB);
+    settings.undoMemoryLimitMb = intValue(values, "UNDO_MEMORY_LIMIT_MB", UndoHistory::DEFAULT_MEMORY_LIMIT_MB);
+    return settings;
+}
@@ -0,0 +1,25 @@
+#include "sourcefile.h"
+#include <QFile>
+#include <QSaveFile>
+
+bool SourceFile::read(const QString &fileName, QString *text, QString *errorString)
+{
+    QFile file(fileName);
+    if (!file.open(QFile::ReadOnly | QFile::Text)) {
+        if (errorString) *errorString = file.errorString();
+        return false;
+    }
+    *text = QString::fromUtf8(file.readAll());
+    return true;
+}
+
+bool SourceFile::write(const QString &fileName, const QString &text, QString *errorString)
+{
+    QSaveFile file(fileName);
+    if (file.open(QFile::WriteOnly | QFile::Text)) {
+        file.write(text.toUtf8());
+        if (file.commit()) return true;
+    }
+    if (errorString) *errorString = file.errorString();
+    return false;
+}
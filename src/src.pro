@@ -0,0 +1,23 @@
+TARGET = CppIDE
+TEMPLATE = app
+
+include(../ide.pri)
+
+SOURCES += \
+    main.cpp
+
+# Resources
+RESOURCES += \
+    ../resources/resources.qrc
+
+# Default rules for deployment.
+qnx: target.path = /tmp/$${TARGET}/bin
+else: unix:!android: target.path = /opt/$${TARGET}/bin
+!isEmpty(target.path): INSTALLS += target
+
+# Output directories
+DESTDIR = $$OUT_PWD/../build/
+OBJECTS_DIR = $$OUT_PWD/../build/obj/
+MOC_DIR = $$OUT_PWD/../build/moc/
+RCC_DIR = $$OUT_PWD/../build/rcc/
+UI_DIR = $$OUT_PWD/../build/ui/
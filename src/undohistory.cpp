@@ -0,0 +1,245 @@
+#include "undohistory.h"
+#include <QTextDocument>
+#include <QTextCursor>
+#include <QKeyEvent>
+#include <QDataStream>
+#include <QDebug>
+
+UndoHistory::UndoHistory(QTextEdit *editor, QObject *parent)
+    : QObject(parent), editor(editor)
+{
+    editor->document()->setUndoRedoEnabled(false);
+    shadow = editor->document()->toPlainText();
+    connect(editor->document(), &QTextDocument::contentsChange, this, &UndoHistory::contentsChanged);
+    editor->installEventFilter(this);
+}
+
+void UndoHistory::setMemoryLimit(qint64 bytes)
+{
+    limit = qMax<qint64>(0, bytes);
+    enforceLimit();
+    emitAvailability();
+}
+
+void UndoHistory::clear()
+{
+    undoSteps.clear();
+    redoSteps.clear();
+    usage = 0;
+    // Replacing the content may have re-enabled the document's own stack
+    editor->document()->setUndoRedoEnabled(false);
+    shadow = editor->document()->toPlainText();
+    lastEdit.invalidate();
+    emitAvailability();
+}
+
+void UndoHistory::undo()
+{
+    if (undoSteps.isEmpty()) return;
+    Step step = undoSteps.takeLast();
+    apply(step, true);
+    redoSteps.append(step);
+    lastEdit.invalidate();
+    emitAvailability();
+}
+
+void UndoHistory::redo()
+{
+    if (redoSteps.isEmpty()) return;
+    Step step = redoSteps.takeLast();
+    apply(step, false);
+    undoSteps.append(step);
+    lastEdit.invalidate();
+    emitAvailability();
+}
+
+bool UndoHistory::eventFilter(QObject *watched, QEvent *event)
+{
+    if (watched == editor
+        && (event->type() == QEvent::KeyPress || event->type() == QEvent::ShortcutOverride)) {
+        QKeyEvent *keyEvent = static_cast<QKeyEvent *>(event);
+        const bool isUndo = keyEvent->matches(QKeySequence::Undo);
+        const bool isRedo = keyEvent->matches(QKeySequence::Redo);
+        if (isUndo || isRedo) {
+            // Claim the key before any menu shortcut, then handle the press itself
+            if (event->type() == QEvent::ShortcutOverride) {
+                event->accept();
+            } else if (isUndo) {
+                undo();
+            } else {
+                redo();
+            }
+            return true;
+        }
+    }
+    return QObject::eventFilter(watched, event);
+}
+
+void UndoHistory::contentsChanged(int position, int charsRemoved, int charsAdded)
+{
+    QTextDocument *doc = editor->document();
+    const int length = doc->characterCount() - 1;  // Without the final paragraph separator
+    if (position > shadow.size() || position > length) {
+        qDebug() << "Undo history lost track of the document, clearing it";
+        clear();
+        return;
+    }
+
+    // Replacing the whole document counts the final separator as well
+    charsRemoved = qBound(0, charsRemoved, shadow.size() - position);
+    charsAdded = qBound(0, charsAdded, length - position);
+
+    Delta delta;
+    delta.position = position;
+    delta.removed = shadow.mid(position, charsRemoved);
+    if (charsAdded > 0) {
+        QTextCursor cursor(doc);
+        cursor.setPosition(position);
+        cursor.setPosition(position + charsAdded, QTextCursor::KeepAnchor);
+        delta.added = cursor.selectedText();
+        delta.added.replace(QChar::ParagraphSeparator, QLatin1Char('\n'));
+    }
+    shadow.replace(position, charsRemoved, delta.added);
+    if (shadow.size() != length) {
+        qDebug() << "Undo history lost track of the document, clearing it";
+        clear();
+        return;
+    }
+
+    if (applying || delta.removed == delta.added) return;
+
+    for (const Step &step : redoSteps) {
+        usage -= step.bytes;
+    }
+    redoSteps.clear();
+
+    if (!merge(delta)) {
+        Step step;
+        step.delta = delta;
+        push(step);
+    }
+    lastEdit.restart();
+    enforceLimit();
+    emitAvailability();
+}
+
+qint64 UndoHistory::sizeOf(const Delta &delta)
+{
+    return qint64(sizeof(Delta)) + (delta.removed.size() + delta.added.size()) * qint64(sizeof(QChar));
+}
+
+void UndoHistory::pack(Step *step)
+{
+    if (!step->packed.isEmpty() || step->bytes < MIN_COMPRESS_BYTES) return;
+
+    QByteArray raw;
+    QDataStream out(&raw, QIODevice::WriteOnly);
+    out << qint32(step->delta.position) << step->delta.removed << step->delta.added;
+
+    // The fastest zlib level; history is written far more often than it is read
+    QByteArray packed = qCompress(raw, 1);
+    if (packed.size() >= step->bytes) return;  // Not worth it, keep the plain delta
+
+    step->packed = packed;
+    step->delta = Delta();
+    step->bytes = packed.size();
+}
+
+UndoHistory::Delta UndoHistory::unpack(const Step &step)
+{
+    if (step.packed.isEmpty()) return step.delta;
+
+    Delta delta;
+    qint32 position = 0;
+    QDataStream in(qUncompress(step.packed));
+    in >> position >> delta.removed >> delta.added;
+    delta.position = position;
+    return delta;
+}
+
+bool UndoHistory::merge(const Delta &delta)
+{
+    if (undoSteps.isEmpty() || !lastEdit.isValid() || lastEdit.elapsed() > MERGE_INTERVAL_MS) return false;
+    Step &step = undoSteps.last();
+    if (!step.packed.isEmpty()) return false;
+    Delta &previous = step.delta;
+
+    const bool typed = delta.removed.isEmpty() && delta.added.size() == 1;
+    const bool erased = delta.added.isEmpty() && delta.removed.size() == 1;
+    if (typed && delta.added.at(0) != QLatin1Char('\n')
+        && !previous.added.isEmpty() && delta.position == previous.position + previous.added.size()) {
+        previous.added += delta.added;
+    } else if (erased && !previous.added.isEmpty()
+               && delta.position == previous.position + previous.added.size() - 1) {
+        // Backspace over text typed in this step
+        previous.added.chop(1);
+        if (previous.added.isEmpty() && previous.removed.isEmpty()) {
+            // Everything typed in the step is gone again, so there is nothing left to undo
+            usage -= step.bytes;
+            undoSteps.removeLast();
+            return true;
+        }
+    } else if (erased && previous.added.isEmpty() && delta.position + 1 == previous.position) {
+        previous.removed.prepend(delta.removed);
+        previous.position = delta.position;
+    } else if (erased && previous.added.isEmpty() && delta.position == previous.position) {
+        previous.removed += delta.removed;
+    } else {
+        return false;
+    }
+
+    usage -= step.bytes;
+    step.bytes = sizeOf(previous);
+    usage += step.bytes;
+    return true;
+}
+
+void UndoHistory::push(Step step)
+{
+    step.bytes = sizeOf(step.delta);
+    usage += step.bytes;
+    undoSteps.append(step);
+
+    // The step that just left the hot window is packed once and stays packed
+    if (undoSteps.size() > HOT_STEPS) {
+        Step &cold = undoSteps[undoSteps.size() - HOT_STEPS - 1];
+        usage -= cold.bytes;
+        pack(&cold);
+        usage += cold.bytes;
+    }
+}
+
+void UndoHistory::apply(const Step &step, bool reverse)
+{
+    const Delta delta = unpack(step);
+    const QString &from = reverse ? delta.added : delta.removed;
+    const QString &to = reverse ? delta.removed : delta.added;
+
+    QTextCursor cursor(editor->document());
+    applying = true;
+    cursor.beginEditBlock();
+    cursor.setPosition(delta.position);
+    cursor.setPosition(delta.position + from.size(), QTextCursor::KeepAnchor);
+    cursor.insertText(to);
+    cursor.endEditBlock();
+    applying = false;
+
+    cursor.setPosition(delta.position + to.size());
+    editor->setTextCursor(cursor);
+    editor->ensureCursorVisible();
+}
+
+void UndoHistory::enforceLimit()
+{
+    // The newest step is kept even when it alone is over the limit
+    while (usage > limit && undoSteps.size() + redoSteps.size() > 1) {
+        Step dropped = !undoSteps.isEmpty() ? undoSteps.takeFirst() : redoSteps.takeFirst();
+        usage -= dropped.bytes;
+    }
+}
+
+void UndoHistory::emitAvailability()
+{
+    emit undoAvailable(canUndo());
+    emit redoAvailable(canRedo());
+}
@@ -0,0 +1,24 @@
+TARGET = completion-replay
+TEMPLATE = app
+
+include(../../ide.pri)
+
+CONFIG += console
+CONFIG -= app_bundle
+
+# The mock endpoint is shared with the benchmark suite
+INCLUDEPATH += $$PWD/../../benchmarks/
+
+SOURCES += \
+    main.cpp \
+    ../../benchmarks/mockcompletionserver.cpp
+
+HEADERS += \
+    ../../benchmarks/mockcompletionserver.h
+
+# Output directories
+DESTDIR = $$OUT_PWD/../../build/
+OBJECTS_DIR = $$OUT_PWD/../../build/obj/completion-replay/
+MOC_DIR = $$OUT_PWD/../../build/moc/completion-replay/
+RCC_DIR = $$OUT_PWD/../../build/rcc/completion-replay/
+UI_DIR = $$OUT_PWD/../../build/ui/completion-replay/
@@ -0,0 +1,219 @@
+#include "completionwidget.h"
+#include "completiontelemetry.h"
+#include "mockcompletionserver.h"
+#include <QApplication>
+#include <QTemporaryDir>
+#include <QEventLoop>
+#include <QTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QMap>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+#include <algorithm>
+
+// Replays recorded completion sessions through CompletionWidget against a
+// local mock server and compares latency and cache hits with the recording.
+//
+//   completion-replay [-delay ms] [-speed factor] [-max-gap ms] [-env file] [-json file] [log or dir...]
+//
+// Only events recorded with COMPLETION_TELEMETRY=replay carry the context
+// needed to replay them; the others still count towards the recorded summary.
+// Whether a suggestion is accepted cannot be replayed, so acceptRate is only
+// meaningful for the recording.
+
+// Removes "<name> <value>" from the arguments and returns the value
+static QString takeOption(QStringList *arguments, const QString &name, const QString &fallback = QString())
+{
+    int index = arguments->indexOf(name);
+    if (index < 0 || index + 1 >= arguments->size()) return fallback;
+    QString value = arguments->at(index + 1);
+    arguments->erase(arguments->begin() + index, arguments->begin() + index + 2);
+    return value;
+}
+
+static void wait(int ms)
+{
+    QEventLoop loop;
+    QTimer::singleShot(qMax(0, ms), &loop, &QEventLoop::quit);
+    loop.exec();
+}
+
+static qint64 percentile(QVector<qint64> values, double fraction)
+{
+    if (values.isEmpty()) return -1;
+    std::sort(values.begin(), values.end());
+    return values.at(qMin(values.size() - 1, int(fraction * values.size())));
+}
+
+static QJsonObject summarize(const QVector<CompletionEvent> &events)
+{
+    int requests = 0;
+    int speculative = 0;
+    int failed = 0;
+    int shown = 0;
+    int prefetchHits = 0;
+    int accepted = 0;
+    QVector<qint64> totals;
+    QVector<qint64> ttfbs;
+    QVector<qint64> queues;
+    for (const CompletionEvent &event : events) {
+        const bool wasShown = event.outcome == CompletionEvent::Accepted
+                              || event.outcome == CompletionEvent::Dismissed;
+        if (event.source == CompletionEvent::Network) {
+            ++requests;
+            if (event.speculative) ++speculative;
+            if (event.outcome == CompletionEvent::Failed) ++failed;
+            if (!event.speculative && event.totalMs >= 0) totals.append(event.totalMs);
+            if (!event.speculative && event.ttfbMs >= 0) ttfbs.append(event.ttfbMs);
+        }
+        if (wasShown) {
+            ++shown;
+            queues.append(event.queueMs);
+            // Shown without a request of its own: from the cache or a prefetch that was still in flight
+            if (event.source == CompletionEvent::Cache || event.speculative) ++prefetchHits;
+            if (event.outcome == CompletionEvent::Accepted) ++accepted;
+        }
+    }
+
+    QJsonObject summary;
+    summary["events"] = events.size();
+    summary["requests"] = requests;
+    summary["speculativeRequests"] = speculative;
+    summary["failedRequests"] = failed;
+    summary["shown"] = shown;
+    summary["prefetchHits"] = prefetchHits;
+    summary["prefetchHitRate"] = shown > 0 ? double(prefetchHits) / shown : 0.0;
+    summary["acceptRate"] = shown > 0 ? double(accepted) / shown : 0.0;
+    summary["queueMsP50"] = percentile(queues, 0.5);
+    summary["ttfbMsP50"] = percentile(ttfbs, 0.5);
+    summary["totalMsP50"] = percentile(totals, 0.5);
+    summary["totalMsP90"] = percentile(totals, 0.9);
+    return summary;
+}
+
+int main(int argc, char *argv[])
+{
+    // The editor is driven programmatically and never needs a display
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QApplication app(argc, argv);
+
+    QStringList arguments = app.arguments().mid(1);
+    const int delay = takeOption(&arguments, "-delay", "100").toInt();
+    const double speed = qMax(0.01, takeOption(&arguments, "-speed", "1").toDouble());
+    const int maxGap = takeOption(&arguments, "-max-gap", "5000").toInt();
+    const QString envPath = takeOption(&arguments, "-env");
+    const QString jsonPath = takeOption(&arguments, "-json");
+    if (arguments.isEmpty()) {
+        arguments.append(CompletionTelemetry::defaultDirectory());
+    }
+
+    QVector<CompletionEvent> recorded;
+    for (const QString &path : arguments) {
+        if (QFileInfo(path).isDir()) {
+            recorded += CompletionTelemetry::readDirectory(path);
+        } else if (!CompletionTelemetry::readLog(path, &recorded)) {
+            QTextStream(stderr) << "Cannot read completion log " << path << "\n";
+            return 1;
+        }
+    }
+
+    // Triggers with recorded context, grouped by session in the order they happened
+    QMap<quint64, QVector<CompletionEvent>> sessions;
+    for (const CompletionEvent &event : recorded) {
+        if (event.source == CompletionEvent::Local) continue;
+        if (event.prefix.isEmpty() && event.suffix.isEmpty()) continue;
+        sessions[event.session].append(event);
+    }
+    for (QVector<CompletionEvent> &events : sessions) {
+        std::stable_sort(events.begin(), events.end(), [](const CompletionEvent &a, const CompletionEvent &b) {
+            return a.elapsedMs < b.elapsedMs;
+        });
+    }
+
+    MockCompletionServer server;
+    server.setResponseDelay(delay);
+    server.setCompletions({"int result = 0;", "return total;", "int result = 0;"});
+    if (!server.start()) {
+        QTextStream(stderr) << "Cannot start the mock completion server\n";
+        return 1;
+    }
+
+    // Settings come from .env in the working directory: the given one, pointed at the mock server
+    QTemporaryDir workDir;
+    if (!workDir.isValid()) return 1;
+    QByteArray env;
+    if (!envPath.isEmpty()) {
+        QFile base(envPath);
+        if (base.open(QIODevice::ReadOnly)) {
+            env = base.readAll() + "\n";
+        }
+    }
+    QString model = recorded.isEmpty() ? QString() : recorded.first().backend.section('@', 0, 0);
+    env += "OPENAI_API_KEY=replay\n";
+    env += "COMPLETION_ENDPOINT=" + server.url().toString().toUtf8() + "\n";
+    env += "COMPLETION_ALTERNATE_ENDPOINT=\n";
+    env += "COMPLETION_HEDGING=0\n";
+    env += "COMPLETION_MODELS=" + (model.isEmpty() ? QByteArray("mock") : model.toUtf8()) + "\n";
+    env += "COMPLETION_TELEMETRY=replay\n";
+    env += "COMPLETION_TELEMETRY_DIR=" + workDir.filePath("telemetry").toUtf8() + "\n";
+    QFile envFile(workDir.filePath(".env"));
+    if (!envFile.open(QIODevice::WriteOnly) || envFile.write(env) != env.size()) return 1;
+    envFile.close();
+    QDir::setCurrent(workDir.path());
+
+    // Responses still in flight when a session ends are given time to land
+    const int settleMs = 2 * delay + 1000;
+    for (const QVector<CompletionEvent> &events : qAsConst(sessions)) {
+        // A fresh widget per session, as each run of the editor starts with an empty cache
+        QTextEdit editor;
+        editor.resize(800, 600);
+        editor.show();
+        CompletionWidget widget(&editor);
+
+        qint64 previous = events.first().elapsedMs;
+        for (const CompletionEvent &event : events) {
+            wait(int(qMin<qint64>(event.elapsedMs - previous, maxGap) / speed));
+            previous = event.elapsedMs;
+
+            widget.hideCompletion();
+            editor.setPlainText(event.prefix + event.suffix);
+            QTextCursor cursor = editor.textCursor();
+            cursor.setPosition(event.prefix.size());
+            editor.setTextCursor(cursor);
+            widget.triggerCompletion(CompletionEvent::Trigger(event.trigger));
+        }
+        wait(settleMs);
+        widget.hideCompletion();
+    }
+
+    QJsonObject report;
+    report["sessions"] = sessions.size();
+    report["mockDelayMs"] = delay;
+    report["mockRequests"] = server.requestCount();
+    report["recorded"] = summarize(recorded);
+    report["replayed"] = summarize(CompletionTelemetry::readDirectory(workDir.filePath("telemetry")));
+
+    QTextStream out(stdout);
+    out << "Replayed " << sessions.size() << " sessions, " << server.requestCount()
+        << " requests to the mock server (" << delay << " ms delay)\n\n";
+    out << QString("%1 %2 %3\n").arg("", -22).arg("recorded", 10).arg("replayed", 10);
+    const QJsonObject recordedSummary = report["recorded"].toObject();
+    const QJsonObject replayedSummary = report["replayed"].toObject();
+    for (const QString &key : recordedSummary.keys()) {
+        out << QString("%1 %2 %3\n").arg(key, -22)
+                   .arg(recordedSummary[key].toDouble(), 10, 'g', 4)
+                   .arg(replayedSummary[key].toDouble(), 10, 'g', 4);
+    }
+
+    if (!jsonPath.isEmpty()) {
+        QFile file(jsonPath);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) return 1;
+        file.write(QJsonDocument(report).toJson());
+    }
+    return 0;
+}